@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+/// Timing results of a benchmark, in seconds per repetition
+struct BenchmarkResult
+{
+    double minTime, medianTime;
+    unsigned numRepetitions;
+};
+
+
+/**
+ * Runs the given workload repeatedly and measures its wall time
+ * 
+ * The workload is first executed numWarmup times without timing, to stabilize caches and CPU
+ * frequency, and then numRepetitions times with timing. The minimum and the median of the
+ * per-repetition times are reported; the minimum is the most reproducible statistic on a quiet
+ * machine, while the median is robust against occasional interference.
+ */
+template<typename Callable>
+BenchmarkResult RunBenchmark(Callable &&workload, unsigned numWarmup = 3,
+  unsigned numRepetitions = 11)
+{
+    for (unsigned i = 0; i < numWarmup; ++i)
+        workload();
+    
+    std::vector<double> times;
+    times.reserve(numRepetitions);
+    
+    for (unsigned i = 0; i < numRepetitions; ++i)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        workload();
+        auto const stop = std::chrono::steady_clock::now();
+        
+        times.push_back(std::chrono::duration<double>(stop - start).count());
+    }
+    
+    std::sort(times.begin(), times.end());
+    
+    BenchmarkResult result;
+    result.minTime = times.front();
+    result.medianTime = times[times.size() / 2];
+    result.numRepetitions = numRepetitions;
+    
+    return result;
+}
+
+
+/// Prints the result of a benchmark, normalized to the given number of items per repetition
+inline void PrintResult(std::string const &name, BenchmarkResult const &result,
+  unsigned long long itemsPerRepetition)
+{
+    std::cout << name << ": " << result.medianTime << " s/rep (min " << result.minTime <<
+      " s) over " << result.numRepetitions << " repetitions";
+    
+    if (itemsPerRepetition > 0)
+        std::cout << ", " << result.minTime / itemsPerRepetition * 1e9 << " ns/item";
+    
+    std::cout << std::endl;
+}
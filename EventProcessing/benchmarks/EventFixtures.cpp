@@ -0,0 +1,167 @@
+#include "EventFixtures.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+
+/// Magic string identifying the fixture file format
+static char const fixtureMagic[8] = {'H', 'T', 'T', 'F', 'I', 'X', '0', '1'};
+
+
+std::vector<FixtureEvent> ReadFixtureFile(std::string const &path)
+{
+    std::ifstream input(path, std::ios::binary);
+    
+    if (not input)
+    {
+        std::ostringstream message;
+        message << "ReadFixtureFile: Failed to open file \"" << path << "\" for reading.";
+        throw std::runtime_error(message.str());
+    }
+    
+    char magic[8];
+    input.read(magic, sizeof(magic));
+    
+    if (not input or std::memcmp(magic, fixtureMagic, sizeof(magic)) != 0)
+    {
+        std::ostringstream message;
+        message << "ReadFixtureFile: File \"" << path << "\" is not a valid fixture file.";
+        throw std::runtime_error(message.str());
+    }
+    
+    uint32_t numEvents = 0;
+    input.read(reinterpret_cast<char *>(&numEvents), sizeof(numEvents));
+    
+    std::vector<FixtureEvent> events;
+    events.reserve(numEvents);
+    
+    for (uint32_t iEvent = 0; iEvent < numEvents; ++iEvent)
+    {
+        FixtureEvent event;
+        
+        float header[5];
+        input.read(reinterpret_cast<char *>(header), sizeof(header));
+        
+        event.leptonPt = header[0];
+        event.leptonEta = header[1];
+        event.leptonPhi = header[2];
+        event.metPt = header[3];
+        event.metPhi = header[4];
+        
+        uint32_t numJets = 0;
+        input.read(reinterpret_cast<char *>(&numJets), sizeof(numJets));
+        
+        for (uint32_t iJet = 0; iJet < numJets; ++iJet)
+        {
+            FixtureJet jet;
+            
+            float kinematics[4];
+            input.read(reinterpret_cast<char *>(kinematics), sizeof(kinematics));
+            
+            jet.pt = kinematics[0];
+            jet.eta = kinematics[1];
+            jet.phi = kinematics[2];
+            jet.mass = kinematics[3];
+            
+            input.read(reinterpret_cast<char *>(&jet.bTag), sizeof(jet.bTag));
+            event.jets.push_back(jet);
+        }
+        
+        if (not input)
+        {
+            std::ostringstream message;
+            message << "ReadFixtureFile: File \"" << path << "\" ended unexpectedly.";
+            throw std::runtime_error(message.str());
+        }
+        
+        events.push_back(std::move(event));
+    }
+    
+    return events;
+}
+
+
+void WriteFixtureFile(std::string const &path, std::vector<FixtureEvent> const &events)
+{
+    std::ofstream output(path, std::ios::binary);
+    
+    if (not output)
+    {
+        std::ostringstream message;
+        message << "WriteFixtureFile: Failed to open file \"" << path << "\" for writing.";
+        throw std::runtime_error(message.str());
+    }
+    
+    output.write(fixtureMagic, sizeof(fixtureMagic));
+    
+    uint32_t const numEvents = events.size();
+    output.write(reinterpret_cast<char const *>(&numEvents), sizeof(numEvents));
+    
+    for (auto const &event: events)
+    {
+        float const header[5] = {event.leptonPt, event.leptonEta, event.leptonPhi,
+          event.metPt, event.metPhi};
+        output.write(reinterpret_cast<char const *>(header), sizeof(header));
+        
+        uint32_t const numJets = event.jets.size();
+        output.write(reinterpret_cast<char const *>(&numJets), sizeof(numJets));
+        
+        for (auto const &jet: event.jets)
+        {
+            float const kinematics[4] = {jet.pt, jet.eta, jet.phi, jet.mass};
+            output.write(reinterpret_cast<char const *>(kinematics), sizeof(kinematics));
+            output.write(reinterpret_cast<char const *>(&jet.bTag), sizeof(jet.bTag));
+        }
+    }
+}
+
+
+std::vector<FixtureEvent> GenerateSyntheticEvents(unsigned numEvents, unsigned long seed)
+{
+    std::mt19937 generator(seed);
+    
+    std::uniform_real_distribution<float> leptonPtDist(30.f, 150.f);
+    std::uniform_real_distribution<float> jetPtDist(20.f, 250.f);
+    std::uniform_real_distribution<float> metDist(20.f, 200.f);
+    std::uniform_real_distribution<float> etaDist(-2.4f, 2.4f);
+    std::uniform_real_distribution<float> phiDist(-3.14159f, 3.14159f);
+    std::uniform_real_distribution<float> jetMassDist(5.f, 30.f);
+    std::uniform_int_distribution<unsigned> numJetsDist(4, 8);
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    
+    std::vector<FixtureEvent> events;
+    events.reserve(numEvents);
+    
+    for (unsigned iEvent = 0; iEvent < numEvents; ++iEvent)
+    {
+        FixtureEvent event;
+        
+        event.leptonPt = leptonPtDist(generator);
+        event.leptonEta = etaDist(generator);
+        event.leptonPhi = phiDist(generator);
+        event.metPt = metDist(generator);
+        event.metPhi = phiDist(generator);
+        
+        unsigned const numJets = numJetsDist(generator);
+        
+        for (unsigned iJet = 0; iJet < numJets; ++iJet)
+        {
+            FixtureJet jet;
+            jet.pt = jetPtDist(generator);
+            jet.eta = etaDist(generator);
+            jet.phi = phiDist(generator);
+            jet.mass = jetMassDist(generator);
+            jet.bTag = (uniform(generator) < 0.4f) ? 1 : 0;
+            
+            event.jets.push_back(jet);
+        }
+        
+        events.push_back(std::move(event));
+    }
+    
+    return events;
+}
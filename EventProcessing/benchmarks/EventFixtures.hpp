@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+/// Reconstructed jet in a recorded fixture event
+struct FixtureJet
+{
+    float pt, eta, phi, mass;
+    unsigned char bTag;
+};
+
+
+/**
+ * Recorded kinematics of one selected event
+ * 
+ * Contains only the quantities consumed by the benchmarked kernels: the tight lepton, the
+ * missing pt, and the selected jets.
+ */
+struct FixtureEvent
+{
+    float leptonPt, leptonEta, leptonPhi;
+    float metPt, metPhi;
+    std::vector<FixtureJet> jets;
+};
+
+
+/**
+ * Reads fixture events from a binary file
+ * 
+ * The file must have been produced with WriteFixtureFile (or the record-fixtures program).
+ * Throws std::runtime_error if the file cannot be opened or is malformed.
+ */
+std::vector<FixtureEvent> ReadFixtureFile(std::string const &path);
+
+/// Writes fixture events into a binary file
+void WriteFixtureFile(std::string const &path, std::vector<FixtureEvent> const &events);
+
+/**
+ * Generates deterministic synthetic events with plausible tt -> l+jets kinematics
+ * 
+ * Used as a fallback when no recorded fixture file is available, so that benchmarks can run
+ * without access to Delphes samples. The same seed always produces the same events.
+ */
+std::vector<FixtureEvent> GenerateSyntheticEvents(unsigned numEvents, unsigned long seed = 7);
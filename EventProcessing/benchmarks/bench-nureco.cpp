@@ -0,0 +1,101 @@
+/**
+ * This benchmark measures the performance of neutrino reconstruction, which is the innermost
+ * kernel of the tt reconstruction. Kinematics are taken from a recorded fixture file when one is
+ * given on the command line; otherwise deterministic synthetic events are used.
+ */
+
+#include "BenchmarkTools.hpp"
+#include "EventFixtures.hpp"
+
+#include <NuReco.hpp>
+
+#include <TLorentzVector.h>
+
+#include <iostream>
+#include <vector>
+
+
+int main(int argc, char **argv)
+{
+    std::vector<FixtureEvent> events;
+    
+    if (argc > 1)
+    {
+        events = ReadFixtureFile(argv[1]);
+        std::cout << "Loaded " << events.size() << " events from \"" << argv[1] << "\".\n";
+    }
+    else
+    {
+        events = GenerateSyntheticEvents(500);
+        std::cout << "Using " << events.size() << " synthetic events "
+          "(pass a fixture file to use recorded kinematics).\n";
+    }
+    
+    
+    // Precompute four-momenta so that the benchmark isolates the solver itself
+    struct SolveInput
+    {
+        TLorentzVector p4Lep, p4B, p4Miss;
+    };
+    
+    std::vector<SolveInput> inputs;
+    
+    for (auto const &event: events)
+    {
+        TLorentzVector p4Lep, p4Miss;
+        p4Lep.SetPtEtaPhiM(event.leptonPt, event.leptonEta, event.leptonPhi, 0.);
+        p4Miss.SetPtEtaPhiM(event.metPt, 0., event.metPhi, 0.);
+        
+        for (auto const &jet: event.jets)
+        {
+            if (jet.bTag != 1)
+                continue;
+            
+            SolveInput input;
+            input.p4Lep = p4Lep;
+            input.p4Miss = p4Miss;
+            input.p4B.SetPtEtaPhiM(jet.pt, jet.eta, jet.phi, jet.mass);
+            inputs.push_back(input);
+        }
+    }
+    
+    std::cout << "Benchmarking " << inputs.size() << " neutrino solves per repetition.\n";
+    
+    
+    NuReco nuReco(173., 80.419002);
+    
+    
+    // Report the fraction of solvable configurations once, outside of the timed loop
+    unsigned long long numSolved = 0;
+    
+    for (auto const &input: inputs)
+    {
+        nuReco.Reconstruct(input.p4Lep, input.p4B, input.p4Miss);
+        
+        if (nuReco.RecoStatus() == 0)
+            ++numSolved;
+    }
+    
+    std::cout << "Solvable configurations: " << numSolved << " of " << inputs.size() << ".\n";
+    
+    
+    double checksum = 0.;
+    
+    auto const result = RunBenchmark([&]{
+        for (auto const &input: inputs)
+        {
+            nuReco.Reconstruct(input.p4Lep, input.p4B, input.p4Miss);
+            
+            if (nuReco.RecoStatus() == 0)
+            {
+                // Accumulate a checksum so that the work cannot be optimized away
+                checksum += nuReco.GetCompatibility();
+            }
+        }
+    });
+    
+    PrintResult("NuReco::Reconstruct", result, inputs.size());
+    std::cout << "Checksum: " << checksum << "\n";
+    
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+/**
+ * This program records kinematics of selected events from Delphes files into a compact fixture
+ * file, which the benchmarks then replay without needing access to the original samples.
+ */
+
+#include "EventFixtures.hpp"
+
+#include <DelphesReader.hpp>
+#include <LJetsSelection.hpp>
+#include <Processor.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+/**
+ * \class FixtureRecorder
+ * 
+ * A plugin that captures the lepton, missing pt, and jets of every selected event
+ */
+class FixtureRecorder: public AnalysisPlugin
+{
+public:
+    FixtureRecorder(DelphesReaderBase const *reader_, LJetsSelection const *selector_,
+      unsigned maxEvents_):
+        reader(reader_), selector(selector_), maxEvents(maxEvents_)
+    {}
+    
+public:
+    std::vector<FixtureEvent> const &GetEvents() const
+    {
+        return events;
+    }
+    
+private:
+    virtual bool ProcessEvent() override
+    {
+        if (events.size() >= maxEvents)
+            return false;
+        
+        FixtureEvent event;
+        
+        auto const &p4Lep = selector->GetLeptonP4();
+        event.leptonPt = p4Lep.Pt();
+        event.leptonEta = p4Lep.Eta();
+        event.leptonPhi = p4Lep.Phi();
+        
+        auto const &met = reader->GetMissPt();
+        event.metPt = met.MET;
+        event.metPhi = met.Phi;
+        
+        for (auto const &jet: reader->GetJets())
+        {
+            FixtureJet fixtureJet;
+            fixtureJet.pt = jet.PT;
+            fixtureJet.eta = jet.Eta;
+            fixtureJet.phi = jet.Phi;
+            fixtureJet.mass = jet.Mass;
+            fixtureJet.bTag = jet.BTag;
+            
+            event.jets.push_back(fixtureJet);
+        }
+        
+        events.push_back(std::move(event));
+        return true;
+    }
+    
+private:
+    /// Non-owning pointers to the reader and selection plugins
+    DelphesReaderBase const *reader;
+    LJetsSelection const *selector;
+    
+    /// Maximal number of events to record
+    unsigned maxEvents;
+    
+    /// Recorded events
+    std::vector<FixtureEvent> events;
+};
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: record-fixtures OUTPUT_FILE INPUT_FILES\n";
+        return EXIT_FAILURE;
+    }
+    
+    
+    Processor processor(argv + 2, argv + argc);
+    
+    DelphesReader reader;
+    processor.RegisterPlugin(&reader);
+    
+    LJetsSelection selection(&reader);
+    processor.RegisterPlugin(&selection);
+    
+    FixtureRecorder recorder(&reader, &selection, 500);
+    processor.RegisterPlugin(&recorder);
+    
+    processor.Run();
+    
+    WriteFixtureFile(argv[1], recorder.GetEvents());
+    std::cout << "Recorded " << recorder.GetEvents().size() << " events into \"" << argv[1] <<
+      "\".\n";
+    
+    
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <Rtypes.h>
+
+#include <TreeWriteOptions.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+class TTree;
+
+
+/**
+ * \class AsyncTreeWriter
+ * 
+ * A facility to fill an output tree, optionally on a dedicated writer thread
+ * 
+ * Objects of this class wrap an output TTree and mimic its booking and filling interface:
+ * a plugin declares branches with method Branch, providing pointers to its buffers, and then
+ * calls Fill for every event. In the default synchronous mode the underlying tree is filled
+ * immediately. In the asynchronous mode the buffer values are instead accumulated in batches,
+ * and a dedicated writer thread performs the actual filling, so that basket compression overlaps
+ * with the processing of subsequent events. Two batch buffers are cycled between the two threads.
+ * 
+ * Only branches of type Float_t are supported, which covers all ntuple-writing plugins. Objects
+ * of this class are created with Processor::BookAsyncTree and follow the same per-file lifetime
+ * as objects created with Processor::Book.
+ */
+class AsyncTreeWriter
+{
+public:
+    /// Constructor from a non-owning pointer to the underlying tree
+    AsyncTreeWriter(TTree *tree, bool asynchronous, unsigned batchSize = 1024);
+    
+    AsyncTreeWriter(AsyncTreeWriter const &) = delete;
+    AsyncTreeWriter &operator=(AsyncTreeWriter const &) = delete;
+    
+    /// Destructor flushes all pending events
+    ~AsyncTreeWriter();
+    
+public:
+    /**
+     * Declares a new branch connected to the given buffer
+     * 
+     * The branch of the underlying tree is created immediately. Redeclaring an existing branch
+     * merely updates the source buffer, which allows plugins to run their per-file booking
+     * against a writer that is kept alive across input files (merged output mode). New branches
+     * must not be declared after the first call to Fill.
+     */
+    void Branch(std::string const &name, Float_t *source);
+    
+    /// Requests that current values of all connected buffers are written as a new entry
+    void Fill();
+    
+    /// Returns a non-owning pointer to the underlying tree
+    TTree *GetTree() const;
+    
+    /**
+     * Sets storage options applied to the underlying tree and its branches
+     * 
+     * Must be called before branches are declared.
+     */
+    void SetWriteOptions(TreeWriteOptions const &options);
+    
+    /**
+     * Writes out all pending events and stops the writer thread
+     * 
+     * Called automatically from the destructor. No entries can be filled afterwards.
+     */
+    void Flush();
+    
+private:
+    /// Hands the accumulated batch over to the writer thread
+    void EnqueueBatch();
+    
+    /// Main function of the writer thread
+    void WriterLoop();
+    
+    /// Fills the underlying tree with all events from the given batch
+    void WriteBatch(std::vector<Float_t> const &batch);
+    
+private:
+    /// Non-owning pointer to the underlying tree
+    TTree *tree;
+    
+    /// Flag showing whether a dedicated writer thread is used
+    bool asynchronous;
+    
+    /// Number of events accumulated before a batch is handed over to the writer thread
+    unsigned batchSize;
+    
+    /// Storage options for the underlying tree and its branches
+    TreeWriteOptions writeOptions;
+    
+    /// Names of the declared branches and non-owning pointers to their source buffers
+    std::vector<std::string> branchNames;
+    std::vector<Float_t const *> sources;
+    
+    /**
+     * Buffer to which the branches of the underlying tree are connected
+     * 
+     * A deque is used so that addresses of the elements remain stable while branches are being
+     * added.
+     */
+    std::deque<Float_t> writeBuffer;
+    
+    /// Flag showing whether filling has started, which also forbids adding further branches
+    bool fillingStarted;
+    
+    /// Flag showing whether Flush has been executed
+    bool flushed;
+    
+    /// Batch of events being accumulated by the producing thread
+    std::vector<Float_t> activeBatch;
+    
+    /// Batch of events handed over to the writer thread
+    std::vector<Float_t> pendingBatch;
+    
+    /// Flag showing that pendingBatch contains events to be written
+    bool pendingAvailable;
+    
+    /// Flag requesting the writer thread to terminate once no work is left
+    bool terminate;
+    
+    /// Mutex and condition variables to synchronize the two threads
+    std::mutex mutex;
+    std::condition_variable condNewWork, condWorkDone;
+    
+    /// The writer thread
+    std::thread writerThread;
+};
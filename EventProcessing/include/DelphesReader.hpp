@@ -20,6 +20,13 @@ public:
     virtual ~DelphesReader();
     
 public:
+    /**
+     * Creates a clone of this plugin with the same configuration
+     * 
+     * Implemented from Plugin.
+     */
+    virtual Plugin *Clone() const override;
+    
     /// Returns collection of electrons
     virtual std::vector<Electron> const &GetElectrons() const override;
     
@@ -29,13 +36,29 @@ public:
     /**
      * Returns collection of jets
      * 
-     * Only jets that meet a kinematic selection are included in the collection.
+     * Only jets that meet a kinematic selection are included in the collection. In the two-phase
+     * reading mode the jet branch is decoded on the first call within each event.
      */
     virtual std::vector<Jet> const &GetJets() const override;
     
     /// Returns missing pt
     virtual MissingET const &GetMissPt() const override;
     
+public:
+    /**
+     * Moves the decoded content of the current event into the given buffer
+     * 
+     * Reimplemented from DelphesReaderBase to include the reconstructed collections.
+     */
+    virtual void ExtractEventData(EventData &data) override;
+    
+    /**
+     * Adopts event content previously extracted with ExtractEventData
+     * 
+     * Reimplemented from DelphesReaderBase.
+     */
+    virtual void AdoptEventData(EventData &data) override;
+    
 protected:
     /// Reads additional collections from the current event
     virtual void ReadEvent() override;
@@ -43,6 +66,10 @@ protected:
     /// Sets up buffers to read branches of Delphes tree with additional collections
     virtual void SetupBuffers() override;
     
+private:
+    /// Decodes the collection of jets from the read buffer
+    void DecodeJets() const;
+    
 private:
     TClonesArray *bfElectrons;
     std::vector<Electron> electrons;
@@ -51,7 +78,19 @@ private:
     std::vector<Muon> muons;
     
     TClonesArray *bfJets;
-    std::vector<Jet> jets;
+    mutable std::vector<Jet> jets;
+    
+    /// Flag showing whether the jets have been decoded for the current event
+    mutable bool jetsDecoded;
     
     TClonesArray *bfMETs;
+    
+    /// Missing pt of the current event, cached to avoid a dynamic_cast per call
+    MissingET *curMET;
+    
+    /// Adopted collections and missing pt, owned by the processing thread (see DelphesReaderBase)
+    std::vector<Electron> servedElectrons;
+    std::vector<Muon> servedMuons;
+    std::vector<Jet> servedJets;
+    MissingET adoptedMET;
 };
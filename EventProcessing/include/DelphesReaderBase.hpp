@@ -4,8 +4,14 @@
 
 #include <classes/DelphesClasses.h>
 
+#include <TLorentzVector.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
 #include <vector>
 
+class TBranch;
 class TClonesArray;
 class TTree;
 
@@ -18,9 +24,40 @@ class TTree;
  * It reads certain generator-level information and provides an interface to access reconstructed
  * objects. Derived classes are provided with hooks SetupBuffers and ReadEvent to allow reading
  * additional collections from a Delphes file.
+ * 
+ * An optional two-phase reading mode is supported (see SetTwoPhaseReading): branches declared as
+ * eager are decoded for every event, while the remaining, typically heavy, branches are only
+ * decoded on first access to the corresponding collections. When most events are rejected early
+ * in the path, for instance on lepton counts, this avoids the decompression of jet and LHE
+ * branches for them.
  */
 class DelphesReaderBase: public Plugin
 {
+public:
+    /**
+     * Decoded content of one event
+     * 
+     * Used to hand complete events from a reading thread to a processing thread in the
+     * pipelined mode of Processor. The vectors are exchanged by swapping, so their storage is
+     * recycled between the threads.
+     */
+    struct EventData
+    {
+        /// Nominal per-event weight and index of the tree entry
+        double weight;
+        long long entry;
+        
+        /// Event collections
+        std::vector<GenParticle> lheParticles;
+        std::vector<LHEFWeight> lheWeights;
+        std::vector<Electron> electrons;
+        std::vector<Muon> muons;
+        std::vector<Jet> jets;
+        
+        /// Missing pt
+        MissingET met;
+    };
+    
 public:
     /// Constructor that defines kinematic selection applied to jets
     DelphesReaderBase(double jetPtThreshold = 20., double jetEtaThreshold = 2.4);
@@ -31,6 +68,9 @@ public:
     /// Sets up reading of Delphes tree
     virtual void BeginFile(TFile *inputFile) override final;
     
+    /// Saves the accepted-entry list of the LHE-level filter if one has been built
+    virtual void EndFile() override final;
+    
     /// Returns collection of electrons
     virtual std::vector<Electron> const &GetElectrons() const = 0;
     
@@ -44,9 +84,28 @@ public:
      */
     virtual std::vector<Jet> const &GetJets() const = 0;
     
+    /**
+     * Returns four-momenta of jets from GetJets
+     * 
+     * The four-momenta are built lazily, at most once per event, so that multiple consumers do
+     * not repeat the conversion from the (pt, eta, phi, m) representation.
+     */
+    std::vector<TLorentzVector> const &GetJetP4s() const;
+    
     /// Returns particles from the LHE record
     std::vector<GenParticle> const &GetLHEParticles() const;
     
+    /// Returns the total number of entries of the current input tree
+    unsigned long long GetNumEvents() const;
+    
+    /**
+     * Returns index of the entry of the input tree loaded for the current event
+     * 
+     * Useful for deriving per-event quantities that must not depend on the processing order,
+     * such as seeds of random-number streams.
+     */
+    long long GetReadEntry() const;
+    
     /**
      * Returns event weights from the LHE record
      * 
@@ -58,16 +117,179 @@ public:
     /// Returns missing pt
     virtual MissingET const &GetMissPt() const = 0;
     
+    /**
+     * Returns four-momentum of missing pt
+     * 
+     * The four-momentum is built lazily, at most once per event.
+     */
+    TLorentzVector const &GetMissPtP4() const;
+    
+    /**
+     * Returns four-momentum of the parton-level top quark pair
+     * 
+     * Computed as the sum of four-momenta of all top quarks in the LHE record. The result is
+     * cached, so that multiple plugins consuming it do not rescan the LHE particles. The
+     * four-momentum is zero if the record contains no top quarks.
+     */
+    TLorentzVector const &GetPartonTTP4() const;
+    
     /// Returns nominal per-event weight
-    double GetWeight() const;
+    virtual double GetWeight() const;
+    
+    /**
+     * Moves the decoded content of the current event into the given buffer
+     * 
+     * Used by the pipelined mode of Processor on the reading thread. Readers that support the
+     * pipelined mode implement this method, handing over their collections with the help of
+     * ExtractCommonEventData; the default implementation reports the mode as unsupported. The
+     * method must not touch any state read by the processing thread.
+     */
+    virtual void ExtractEventData(EventData &data);
+    
+    /**
+     * Adopts event content previously extracted with ExtractEventData
+     * 
+     * Used by the pipelined mode of Processor on the processing thread. After the call, the
+     * usual accessors serve the adopted event from buffers owned by that thread. The default
+     * implementation reports the mode as unsupported.
+     */
+    virtual void AdoptEventData(EventData &data);
     
     /// Reads next event from the input file
     virtual EventOutcome ProcessEventToOutcome() override final;
     
+    /**
+     * Sets the size of the read-ahead cache of the input trees
+     * 
+     * Enables the standard tree cache with the given size, in bytes, covering all enabled
+     * branches. Mostly useful when inputs are streamed from remote storage.
+     */
+    void SetCacheSize(long long bytes);
+    
+    /**
+     * Restricts processing to the given range of entries of every input tree
+     * 
+     * Only entries in [firstEntry, firstEntry + numEntries), clamped to the actual length of
+     * each tree, are processed. Together with Processor::SetSharding this allows splitting very
+     * large files deterministically between jobs. While a range is active, the entry-list cache
+     * of the LHE-level filter is bypassed, since it describes whole files.
+     */
+    void SetEntryRange(unsigned long long firstEntry, unsigned long long numEntries);
+    
+    /**
+     * Restricts the event loop of the current file to the given list of entries
+     * 
+     * Entries outside of the list are skipped at the tree level, so their baskets are never
+     * decompressed. Used by Processor to replay persistent selection caches; must be called
+     * after BeginFile and supersedes the LHE-level filter for the file.
+     */
+    void UseEntryList(std::vector<long long> const &entries);
+    
+    /**
+     * Sets a filter evaluated on PDG IDs of the LHE record before the event is decoded
+     * 
+     * For every entry, only the branch with PDG IDs of LHE particles is read, and the filter is
+     * evaluated on them; entries failing it are skipped without decoding anything else. Since
+     * input files are immutable, the list of accepted entries is additionally persisted in a
+     * sidecar file (see EntryListCache), keyed by the given filter name, and subsequent jobs
+     * jump straight to the accepted entries. Rejected events never reach the plugin path.
+     */
+    void SetLHEPreFilter(std::function<bool(std::vector<int> const &)> filter,
+      std::string const &name);
+    
     /// Requests reading of LHE weights
     void SetReadLHEWeights(bool on = true);
     
+    /**
+     * Requests two-phase reading of the input trees
+     * 
+     * In this mode only branches declared as eager (see DeclareEagerBranch) are decoded
+     * upfront for each event; the remaining branches are decoded lazily, on first access within
+     * the event. Must be called before processing starts.
+     */
+    void SetTwoPhaseReading(bool on = true);
+    
 protected:
+    /**
+     * Hands over the per-event content managed by this base class
+     * 
+     * Helper for ExtractEventData implementations; runs on the reading thread and forces lazy
+     * decoding of the LHE collections before swapping them into the buffer.
+     */
+    void ExtractCommonEventData(EventData &data);
+    
+    /**
+     * Adopts the per-event content managed by this base class
+     * 
+     * Helper for AdoptEventData implementations; runs on the processing thread.
+     */
+    void AdoptCommonEventData(EventData &data);
+    
+    /// Decodes LHE particles from the read buffer
+    void DecodeLHEParticles() const;
+    
+    /// Decodes LHE weights from the read buffer
+    void DecodeLHEWeights() const;
+    
+    /**
+     * Declares a branch that must be decoded upfront for every event in two-phase reading
+     * 
+     * To be called from SetupBuffers. Branches not declared as eager are decoded lazily. The
+     * declaration has no effect when two-phase reading is not enabled.
+     */
+    void DeclareEagerBranch(std::string const &name);
+    
+    /**
+     * Reads the branch with the given name for the current event
+     * 
+     * Used by derived classes to load lazy branches on first access to their collections.
+     */
+    void ReadBranchEntry(std::string const &name) const;
+    
+    /**
+     * Builds four-momenta of the jets returned by GetJets
+     * 
+     * Hook used by GetJetP4s. The default implementation converts the Delphes objects; readers
+     * that hold the kinematics in flat arrays override it to avoid materializing the objects.
+     */
+    virtual void BuildJetP4s(std::vector<TLorentzVector> &p4s) const;
+    
+    /**
+     * Copies the full configuration of this reader into the given clone
+     * 
+     * Covers the jet selection, reading modes, the LHE-level filter, the entry range, and the
+     * cache size. To be used by Clone implementations, so that newly added settings cannot be
+     * forgotten in individual readers.
+     */
+    void CopyConfiguration(DelphesReaderBase &clone) const;
+    
+    /**
+     * Reads PDG IDs of the LHE record of the given entry into pidScratch
+     * 
+     * Used by the LHE-level filter to evaluate its predicate before the event is decoded. The
+     * default implementation reads the master LHE branch, which keeps the size of the container
+     * up to date; the record is small, so the pushdown still skips the heavy branches. Derived
+     * classes with a different reading layout must override this method accordingly.
+     */
+    virtual void ReadLHEPidsForFilter(long long entry);
+    
+    /**
+     * Appends a copy of the given object to a pooled per-event collection
+     * 
+     * Per-event collections are treated as object pools: elements left over from the previous
+     * event are assigned to instead of being destroyed and recreated, so that resources held by
+     * the objects and the capacity of the vector are reused and no per-event heap traffic
+     * occurs while the multiplicity stays stable. Argument numUsed counts the objects appended
+     * in the current event and is incremented by the call. After the last object has been
+     * appended, TrimPool must be called to drop unused leftover elements.
+     */
+    template<typename T>
+    static void AppendToPool(std::vector<T> &collection, unsigned &numUsed, T const &object);
+    
+    /// Removes elements beyond the first numUsed ones from a pooled per-event collection
+    template<typename T>
+    static void TrimPool(std::vector<T> &collection, unsigned numUsed);
+    
     /**
      * A hook to read content of the current event
      * 
@@ -89,23 +311,140 @@ protected:
     /// Kinematic selection applied to jets
     double jetPtThreshold, jetEtaThreshold;
     
-    /// Non-owning pointer to Delphes tree
+    /// Flag showing whether two-phase reading is enabled
+    bool twoPhaseReading;
+    
+    /// Restriction to a range of entries; active when entryRangeSet
+    bool entryRangeSet;
+    unsigned long long entryRangeFirst, entryRangeCount;
+    
+    /// Size of the read-ahead cache of the input trees, in bytes; 0 disables the cache
+    long long treeCacheSize;
+    
+    /**
+     * Name of the input tree
+     * 
+     * Defaults to the Delphes tree; derived classes reading other formats can override it in
+     * their constructors.
+     */
+    std::string treeName;
+    
+    /// Non-owning pointer to input tree
     TTree *tree;
     
     /// Total number of events in the tree and index of the current event
     unsigned long long numEvents, iEvent;
     
+    /// Index of the entry loaded for the current event
+    long long curEntry;
+    
     /// Buffer to read global generator-level information about an event
     TClonesArray *bfEvents;
     
     /// Buffer to read LHE particles
     TClonesArray *bfLHEParticles;
-    std::vector<GenParticle> lheParticles;
+    mutable std::vector<GenParticle> lheParticles;
     
     /// Buffer to read LHE weights
     TClonesArray *bfLHEWeights;
-    std::vector<LHEFWeight> lheWeights;
+    mutable std::vector<LHEFWeight> lheWeights;
     
     /// Indicates whether LHE weights should be read
     bool readLHEWeights;
+    
+    /// Scratch buffer with PDG IDs passed to the LHE-level filter
+    std::vector<int> pidScratch;
+    
+    /// Flag showing that the served event has been adopted from a pipeline buffer
+    bool eventAdopted;
+    
+    /// Weight and entry index of the adopted event
+    double adoptedWeight;
+    long long adoptedEntry;
+    
+    /**
+     * Adopted LHE collections
+     * 
+     * Owned by the processing thread of the pipelined mode, while the standard collections
+     * serve as decode buffers of the reading thread.
+     */
+    std::vector<GenParticle> servedLHEParticles;
+    std::vector<LHEFWeight> servedLHEWeights;
+    
+    /**
+     * Flags showing whether the LHE collections have been decoded for the current event
+     * 
+     * Derived classes that fill the LHE collections themselves, bypassing the standard decoding
+     * from the Delphes branches, must set these flags in their ReadEvent implementations.
+     */
+    mutable bool lheParticlesDecoded, lheWeightsDecoded;
+    
+private:
+    /**
+     * Positions curEntry at the next entry accepted by the LHE-level filter
+     * 
+     * Returns false when no entries are left. Only called when the filter is set.
+     */
+    bool AdvanceToAcceptedEntry();
+    
+private:
+    /// Names of branches to be decoded upfront in two-phase reading
+    std::vector<std::string> eagerBranchNames;
+    
+    /// Resolved eager branches of the current input tree
+    std::vector<TBranch *> eagerBranches;
+    
+    /// LHE-level filter and its name, used to key the entry-list cache
+    std::function<bool(std::vector<int> const &)> lhePreFilter;
+    std::string lhePreFilterName;
+    
+    /// Master branch with LHE particles, read by the filter before the event is decoded
+    TBranch *brLHEFilter;
+    
+    /// Flag showing whether a cached accepted-entry list is being replayed
+    bool usingCachedEntries;
+    
+    /// Cached accepted entries and the index of the next one to process
+    std::vector<long long> acceptedEntries;
+    std::size_t nextAcceptedEntry;
+    
+    /// Entries accepted by the filter in the current file, to be saved in the cache
+    std::vector<long long> newAcceptedEntries;
+    
+    /**
+     * Cached derived quantities of the current event
+     * 
+     * Computed lazily by the corresponding accessors and invalidated when a new event is read.
+     */
+    mutable TLorentzVector partonTTP4, missPtP4;
+    mutable std::vector<TLorentzVector> jetP4s;
+    
+    /**
+     * Validity flags of the cached derived quantities
+     * 
+     * Atomic because in the pipelined mode the reading thread clears them while the processing
+     * thread may be setting them; the only effect of that interleaving is a spurious
+     * recomputation.
+     */
+    mutable std::atomic<bool> partonTTP4Cached, missPtP4Cached, jetP4sCached;
 };
+
+
+template<typename T>
+void DelphesReaderBase::AppendToPool(std::vector<T> &collection, unsigned &numUsed,
+  T const &object)
+{
+    if (numUsed < collection.size())
+        collection[numUsed] = object;
+    else
+        collection.push_back(object);
+    
+    ++numUsed;
+}
+
+
+template<typename T>
+void DelphesReaderBase::TrimPool(std::vector<T> &collection, unsigned numUsed)
+{
+    collection.erase(collection.begin() + numUsed, collection.end());
+}
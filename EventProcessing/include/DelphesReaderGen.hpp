@@ -20,6 +20,13 @@ public:
     virtual ~DelphesReaderGen();
     
 public:
+    /**
+     * Creates a clone of this plugin with the same configuration
+     * 
+     * Implemented from Plugin.
+     */
+    virtual Plugin *Clone() const override;
+    
     /// Returns collection of electrons
     virtual std::vector<Electron> const &GetElectrons() const override;
     
@@ -36,6 +43,20 @@ public:
     /// Returns missing pt
     virtual MissingET const &GetMissPt() const override;
     
+    /**
+     * Moves the decoded content of the current event into the given buffer
+     * 
+     * Reimplemented from DelphesReaderBase to include the generator-level collections.
+     */
+    virtual void ExtractEventData(EventData &data) override;
+    
+    /**
+     * Adopts event content previously extracted with ExtractEventData
+     * 
+     * Reimplemented from DelphesReaderBase.
+     */
+    virtual void AdoptEventData(EventData &data) override;
+    
 protected:
     /// Reads additional collections from the current event
     virtual void ReadEvent() override;
@@ -51,4 +72,10 @@ private:
     
     std::vector<Electron> electrons;
     std::vector<Muon> muons;
+    
+    /// Adopted collections and missing pt, owned by the processing thread (see DelphesReaderBase)
+    std::vector<Electron> servedElectrons;
+    std::vector<Muon> servedMuons;
+    std::vector<Jet> servedJets;
+    MissingET adoptedMET;
 };
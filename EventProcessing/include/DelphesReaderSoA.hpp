@@ -0,0 +1,230 @@
+#pragma once
+
+#include <DelphesReaderBase.hpp>
+
+#include <string>
+#include <vector>
+
+
+/**
+ * \class DelphesReaderSoA
+ * 
+ * A plugin that reads Delphes files into flat structure-of-arrays buffers
+ * 
+ * This is a drop-in replacement of class DelphesReader that avoids materializing the fat Delphes
+ * classes. The tree is read in the decomposed-object (MakeClass) mode, so only the scalar leaves
+ * that are actually consumed downstream (pt, eta, phi, mass, b-tag decision, charge, and a
+ * minimal subset of the LHE record) are decoded, directly into contiguous arrays, bypassing the
+ * TClonesArray buffers entirely. Since the decomposed mode applies to the whole tree, this
+ * reader performs all reading itself, including the event weight and the LHE record, instead of
+ * delegating to DelphesReaderBase.
+ * 
+ * The arrays are exposed with dedicated accessors, which downstream code consumes without
+ * per-object copies: LJetsSelection evaluates its cuts directly on the arrays, and the jet
+ * four-momenta served through DelphesReaderBase::GetJetP4s, which TTReco consumes, are built
+ * straight from the arrays. The standard object interface remains available for the remaining
+ * consumers; the corresponding collections are only built on first access, with unused fields
+ * left zeroed, so events rejected early never materialize any Delphes objects.
+ * 
+ * The buffers have fixed capacities. Since the decomposed-mode decoding writes the full object
+ * count of an event with no bounds knowledge, the maximal multiplicities of all read
+ * collections are checked against the capacities when each input tree is set up, before
+ * anything is read from it, and a file that does not fit is rejected with an exception.
+ */
+class DelphesReaderSoA: public DelphesReaderBase
+{
+public:
+    /**
+     * Flat arrays describing a collection of charged leptons
+     * 
+     * Objects are ordered in decreasing pt.
+     */
+    struct LeptonArrays
+    {
+        /// Maximal supported number of objects in the collection
+        static int const maxSize = 256;
+        
+        /// Actual number of objects in the current event
+        Int_t size;
+        
+        // Kinematic properties
+        Float_t pt[maxSize], eta[maxSize], phi[maxSize];
+        
+        /// Electric charge
+        Int_t charge[maxSize];
+        
+        /// Swaps objects with the given indices
+        void SwapObjects(int i, int j);
+    };
+    
+    /**
+     * Flat arrays describing the collection of jets
+     * 
+     * Only jets that meet the kinematic selection are included. Objects are ordered in
+     * decreasing pt.
+     */
+    struct JetArrays
+    {
+        /// Maximal supported number of objects in the collection
+        static int const maxSize = 256;
+        
+        /// Actual number of objects in the current event
+        Int_t size;
+        
+        // Kinematic properties
+        Float_t pt[maxSize], eta[maxSize], phi[maxSize], mass[maxSize];
+        
+        /// b-tagging decision
+        UInt_t btag[maxSize];
+        
+        /// Swaps objects with the given indices
+        void SwapObjects(int i, int j);
+    };
+    
+public:
+    DelphesReaderSoA();
+    
+    virtual ~DelphesReaderSoA() = default;
+    
+public:
+    /**
+     * Creates a clone of this plugin with the same configuration
+     * 
+     * Implemented from Plugin.
+     */
+    virtual Plugin *Clone() const override;
+    
+    /// Returns flat arrays with properties of electrons
+    LeptonArrays const &GetElectronArrays() const;
+    
+    /**
+     * Returns collection of electrons
+     * 
+     * Reimplemented from DelphesReaderBase. The collection is built from the flat arrays on
+     * first access; only fields PT, Eta, Phi, and Charge are set.
+     */
+    virtual std::vector<Electron> const &GetElectrons() const override;
+    
+    /// Returns flat arrays with properties of jets passing the kinematic selection
+    JetArrays const &GetJetArrays() const;
+    
+    /**
+     * Returns collection of jets
+     * 
+     * Reimplemented from DelphesReaderBase. The collection is built from the flat arrays on
+     * first access; only fields PT, Eta, Phi, Mass, and BTag are set.
+     */
+    virtual std::vector<Jet> const &GetJets() const override;
+    
+    /// Returns flat arrays with properties of muons
+    LeptonArrays const &GetMuonArrays() const;
+    
+    /**
+     * Returns collection of muons
+     * 
+     * Reimplemented from DelphesReaderBase. The collection is built from the flat arrays on
+     * first access; only fields PT, Eta, Phi, and Charge are set.
+     */
+    virtual std::vector<Muon> const &GetMuons() const override;
+    
+    /// Returns missing pt
+    virtual MissingET const &GetMissPt() const override;
+    
+    /**
+     * Returns nominal per-event weight
+     * 
+     * Reimplemented from DelphesReaderBase since the weight is read into a flat buffer.
+     */
+    virtual double GetWeight() const override;
+    
+protected:
+    /**
+     * Builds jet four-momenta directly from the flat arrays
+     * 
+     * Reimplemented from DelphesReaderBase, so that consumers of GetJetP4s do not trigger the
+     * materialization of Delphes objects.
+     */
+    virtual void BuildJetP4s(std::vector<TLorentzVector> &p4s) const override;
+    
+    /// Builds the event collections from the flat arrays
+    virtual void ReadEvent() override;
+    
+    /**
+     * Reads PDG IDs of the LHE record of the given entry into pidScratch
+     * 
+     * Reimplemented from DelphesReaderBase to work with the flat arrays.
+     */
+    virtual void ReadLHEPidsForFilter(long long entry) override;
+    
+    /// Sets up reading of scalar leaves in the decomposed-object mode
+    virtual void SetupBuffers() override;
+    
+private:
+    /// Enables scalar leaves of a lepton branch and connects them to the given arrays
+    void ConnectLeptonBranch(std::string const &branchName, LeptonArrays &arrays);
+    
+    /// Reorders objects in the [0, size) range of the given arrays in decreasing pt
+    template<typename Arrays>
+    static void SortByPt(Arrays &arrays);
+    
+    /**
+     * Checks that the multiplicity of a collection never exceeds the capacity of its buffers
+     * 
+     * The maximum is taken from the count leaf of the given branch of the current tree, which
+     * is the same information the MakeClass generator uses to size its arrays. Called when a
+     * new tree is set up, before anything is read from it. Throws if the capacity is
+     * insufficient or the count leaf cannot be found.
+     */
+    void ValidateCapacity(std::string const &branchName, long long capacity) const;
+    
+private:
+    /**
+     * Maximal supported numbers of LHE particles and of LHE weight records
+     * 
+     * Kept separate from the capacities of the reconstructed collections since the LHE
+     * multiplicity is unrelated to them and can reach hundreds of entries.
+     */
+    static int const maxLHEParticles = 512;
+    static int const maxLHEWeights = 512;
+    
+private:
+    /// Arrays to read collections of leptons
+    LeptonArrays electrons, muons;
+    
+    /// Arrays to read the collection of jets
+    JetArrays jets;
+    
+    /// Buffers to read the missing pt
+    Int_t numMET;
+    Float_t metMet[1], metPhi[1];
+    
+    /// Missing pt in the representation expected by the standard interface
+    MissingET met;
+    
+    /// Buffers to read the event weight
+    Int_t numEventRecords;
+    Float_t eventWeight[1];
+    
+    /// Buffers to read the LHE record
+    Int_t numLHEParticles;
+    Int_t lhePid[maxLHEParticles], lheMother[maxLHEParticles];
+    Float_t lhePt[maxLHEParticles], lheEta[maxLHEParticles],
+      lhePhi[maxLHEParticles], lheMass[maxLHEParticles];
+    
+    /// Buffers to read the LHE weights
+    Int_t numLHEWeightRecords;
+    Int_t lheWeightId[maxLHEWeights];
+    Float_t lheWeightValue[maxLHEWeights];
+    
+    /**
+     * Collections of Delphes objects built from the flat arrays
+     * 
+     * Only filled on demand, for consumers of the standard interface of DelphesReaderBase.
+     */
+    mutable std::vector<Electron> electronObjects;
+    mutable std::vector<Muon> muonObjects;
+    mutable std::vector<Jet> jetObjects;
+    
+    /// Flags showing whether the collections of Delphes objects are in sync with the arrays
+    mutable bool electronObjectsBuilt, muonObjectsBuilt, jetObjectsBuilt;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+/**
+ * \class EntryListCache
+ * 
+ * Persistence of per-file lists of accepted tree entries
+ * 
+ * Since the same immutable input files are processed many times, lists of entries accepted by a
+ * deterministic selection can be cached in small sidecar files next to the inputs and replayed
+ * in subsequent jobs, skipping rejected entries without ever decompressing them. A cache is
+ * identified by a tag describing the selection; it also records the total number of entries of
+ * the tree, which protects against replaying a stale cache against a different file.
+ * 
+ * Caching is best effort: a failure to write a sidecar file (for instance, into a read-only
+ * directory) is silently ignored.
+ */
+class EntryListCache
+{
+public:
+    /// Builds the path of the sidecar file for the given input file and tag
+    static std::string BuildPath(std::string const &inputFile, std::string const &tag);
+    
+    /**
+     * Loads a cached list of accepted entries
+     * 
+     * Returns false if the sidecar file does not exist or does not match the given tag and
+     * number of entries.
+     */
+    static bool Load(std::string const &path, std::string const &tag,
+      unsigned long long numEntries, std::vector<long long> &entries);
+    
+    /// Saves a list of accepted entries, silently ignoring write failures
+    static void Save(std::string const &path, std::string const &tag,
+      unsigned long long numEntries, std::vector<long long> const &entries);
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+/**
+ * \class HistogramBuffer
+ * 
+ * A plain accumulation buffer standing in for a booked histogram
+ * 
+ * Plugins declare histograms through Processor::BookHistogram and receive handles of this type,
+ * which stay valid for the whole job. Filling goes into plain arrays of weight sums, with no
+ * dependence on gDirectory or any other global state, which makes the handles safe to use from
+ * whichever thread runs the plugin. The actual ROOT histograms are only materialized into the
+ * output file by Processor when an input file has been processed, and the buffers are then
+ * reset. This also removes the need for plugins to rebook their histograms for every input
+ * file.
+ */
+class HistogramBuffer
+{
+public:
+    /// Constructor from the in-file directory, name, title, and bin edges
+    HistogramBuffer(std::string const &inFileDirectory, std::string const &name,
+      std::string const &title, std::vector<double> const &binning);
+    
+public:
+    /// Returns the bin edges
+    std::vector<double> const &Binning() const;
+    
+    /// Returns the in-file directory
+    std::string const &Directory() const;
+    
+    /// Adds an entry with the given weight
+    void Fill(double x, double weight = 1.);
+    
+    /// Returns the name of the histogram
+    std::string const &Name() const;
+    
+    /// Returns the number of accumulated entries
+    unsigned long long NumFills() const;
+    
+    /// Resets the accumulated sums
+    void Reset();
+    
+    /// Returns the accumulated sums of weights, with the underflow at index 0
+    std::vector<double> const &Sums() const;
+    
+    /// Returns the accumulated sums of squared weights
+    std::vector<double> const &SumsSquared() const;
+    
+    /// Returns the title of the histogram
+    std::string const &Title() const;
+    
+private:
+    /// In-file directory, name, and title of the histogram
+    std::string inFileDirectory, name, title;
+    
+    /// Bin edges
+    std::vector<double> binning;
+    
+    /// Accumulated sums of weights and of squared weights, with the underflow at index 0
+    std::vector<double> sums, sums2;
+    
+    /// Number of accumulated entries
+    unsigned long long numFills;
+};
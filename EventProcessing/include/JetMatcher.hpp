@@ -0,0 +1,53 @@
+#pragma once
+
+#include <classes/DelphesClasses.h>
+
+#include <vector>
+
+
+/**
+ * \class JetMatcher
+ * 
+ * Matches generator-level particles to reconstructed jets by angular distance
+ * 
+ * The coordinates of the jet collection are copied once per event into flat arrays, and all
+ * query particles are then matched in a single scan over the jets with a branch-light inner
+ * loop, instead of one full scan with per-pair pow and Phi_mpi_pi calls per particle. The class
+ * also implements the requirement, shared by its users, that distinct particles must be matched
+ * to distinct jets.
+ */
+class JetMatcher
+{
+public:
+    JetMatcher();
+    
+public:
+    /**
+     * Matches the given particle to the closest jet
+     * 
+     * If no jet is found within the given distance, a null pointer is returned. SetJets must
+     * have been called for the current event.
+     */
+    Jet const *Match(GenParticle const &particle, double maxDR) const;
+    
+    /**
+     * Matches several particles to mutually distinct jets
+     * 
+     * Every particle is matched independently to its closest jet within maxDR, all in one scan
+     * over the jet collection. Returns true if all particles have been matched and no jet is
+     * shared between two particles; the matched jets are then found in matches, in the order of
+     * the query particles.
+     */
+    bool MatchDistinct(std::vector<GenParticle const *> const &particles, double maxDR,
+      std::vector<Jet const *> &matches) const;
+    
+    /// Rebuilds the internal arrays for the given jet collection
+    void SetJets(std::vector<Jet> const &jets);
+    
+private:
+    /// Non-owning pointer to the current jet collection
+    std::vector<Jet> const *jets;
+    
+    /// Flat arrays with coordinates of the jets
+    std::vector<double> etas, phis;
+};
@@ -2,6 +2,8 @@
 
 #include <AnalysisPlugin.hpp>
 
+#include <vector>
+
 class DelphesReaderBase;
 
 
@@ -15,6 +17,29 @@ class LJetsLHEFilter: public AnalysisPlugin
 public:
     LJetsLHEFilter(DelphesReaderBase const *reader);
     
+public:
+    /**
+     * Checks PDG IDs of an LHE record for the targeted l+jets final state
+     * 
+     * Shared between the per-event selection of this plugin and the reader-level filter
+     * pushdown (DelphesReaderBase::SetLHEPreFilter).
+     */
+    static bool PassPIDs(std::vector<int> const &pids);
+    
+    /**
+     * Creates a clone of this plugin
+     * 
+     * Implemented from Plugin.
+     */
+    virtual Plugin *Clone() const override;
+    
+    /**
+     * Redirects pointer to the reader plugin
+     * 
+     * Reimplemented from Plugin.
+     */
+    virtual void RebindPlugin(Plugin const *from, Plugin const *to) override;
+    
 private:
     /// Applies event selection
     virtual bool ProcessEvent() override;
@@ -22,4 +47,7 @@ private:
 private:
     /// Non-owning pointer to reader plugin
     DelphesReaderBase const *reader;
+    
+    /// Scratch buffer with PDG IDs of the current event
+    std::vector<int> pids;
 };
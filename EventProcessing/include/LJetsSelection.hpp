@@ -7,6 +7,9 @@
 #include <TLorentzVector.h>
 
 
+class DelphesReaderSoA;
+
+
 /**
  * \class LJetsSelection
  * 
@@ -15,6 +18,9 @@
  * Event is required to contain exactly one tight electron or muon, no additional leptons, at least
  * four jets, and at least two of them must be b-tagged. Additionally, the value of m_T(W) must be
  * above a threshold.
+ * 
+ * When the reader is a DelphesReaderSoA, the cuts are evaluated directly on its flat arrays,
+ * without materializing any Delphes objects.
  */
 class LJetsSelection: public AnalysisPlugin
 {
@@ -23,6 +29,13 @@ public:
     LJetsSelection(DelphesReaderBase const *reader);
     
 public:
+    /**
+     * Creates a clone of this plugin with the same configuration
+     * 
+     * Implemented from Plugin.
+     */
+    virtual Plugin *Clone() const override;
+    
     /// Returns four-momentum of the only tight lepton in the current accepted event
     TLorentzVector const &GetLeptonP4() const;
     
@@ -32,10 +45,24 @@ public:
     /// Applies event selection
     virtual bool ProcessEvent() override;
     
+    /**
+     * Redirects pointer to the reader plugin
+     * 
+     * Reimplemented from Plugin.
+     */
+    virtual void RebindPlugin(Plugin const *from, Plugin const *to) override;
+    
+private:
+    /// Applies the event selection on the flat arrays of a structure-of-arrays reader
+    bool ProcessEventSoA();
+    
 private:
     /// Non-owning pointer to reader plugin
     DelphesReaderBase const *reader;
     
+    /// The same reader when it provides structure-of-arrays access; null otherwise
+    DelphesReaderSoA const *soaReader;
+    
     /// Thresholds for electrons
     double ptEleTight, ptEleLoose;
     
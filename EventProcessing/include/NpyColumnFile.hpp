@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Rtypes.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+/**
+ * \class NpyColumnFile
+ * 
+ * Incremental writer of a single column in the NumPy .npy format
+ * 
+ * Values are appended one by one and written out in buffered chunks; the header, which contains
+ * the length of the column, is patched when the file is closed. The resulting files follow
+ * version 1.0 of the .npy format with dtype '<f4' (little-endian 32-bit floats, matching this
+ * platform), so the Python side can load a many-million-event column instantly with
+ * numpy.load(..., mmap_mode='r') instead of iterating a ROOT tree.
+ */
+class NpyColumnFile
+{
+public:
+    /// Constructor opens the file and reserves space for the header
+    NpyColumnFile(std::string const &path);
+    
+    NpyColumnFile(NpyColumnFile const &) = delete;
+    NpyColumnFile &operator=(NpyColumnFile const &) = delete;
+    
+    /// Destructor finalizes the file
+    ~NpyColumnFile();
+    
+public:
+    /// Appends one value to the column
+    void Append(Float_t value);
+    
+    /// Flushes buffered values and patches the header with the final length
+    void Close();
+    
+private:
+    /// Writes the header for the given column length
+    void WriteHeader(unsigned long long numValues);
+    
+    /// Writes out the buffered values
+    void FlushBuffer();
+    
+private:
+    /// Path of the file, for error reporting
+    std::string path;
+    
+    /// Output stream
+    std::ofstream output;
+    
+    /// Buffered values not yet written out
+    std::vector<Float_t> buffer;
+    
+    /// Total number of appended values
+    unsigned long long numValues;
+    
+    /// Flag showing whether the file has been finalized
+    bool closed;
+};
@@ -5,6 +5,7 @@
 #include <TLorentzVector.h>
 
 #include <utility>
+#include <vector>
 
 
 /**
@@ -26,6 +27,68 @@ private:
     using Matrix = ROOT::Math::SMatrix<double, 3>;
     using Vector = ROOT::Math::SVector<double, 3>;
     
+    /**
+     * \brief Coefficients of a trigonometric form a c^2 + b s^2 + k + 2 (d cs + e c + g s)
+     * 
+     * For a symmetric matrix F and vector T = (c, s, 1)', the quadratic form T'FT reduces to
+     * this expression with a = F00, b = F11, k = F22, d = F01, e = F02, g = F12. Storing the
+     * six coefficients instead of the matrix turns each evaluation in the minimization into a
+     * handful of scalar operations.
+     */
+    struct TrigForm
+    {
+        double a, b, k, d, e, g;
+        
+        /// Evaluates the form at the given cosine and sine of the parameter
+        double Evaluate(double c, double s) const
+        {
+            return a * c * c + b * s * s + k + 2 * (d * c * s + e * c + g * s);
+        }
+    };
+    
+    /**
+     * \brief Quantities that depend only on the lepton
+     * 
+     * Computed once per batch of candidate b-jets, so that per-candidate solves do not repeat
+     * the lepton-side kinematics and rotations.
+     */
+    struct LeptonContext
+    {
+        /// Quantities from Sec. 2 of the paper that involve only the lepton
+        double x0, betaLep, pLep, epsilon2, Sx;
+        
+        /// Product of the rotations about the z and y axes from Sec. 2.5
+        Matrix RyRz;
+    };
+    
+public:
+    /// \brief Counters describing the work done by this object
+    struct Stats
+    {
+        Stats():
+            numSolves(0), numUnsolvable(0), numGridScanFallbacks(0)
+        {}
+        
+        /// Number of attempted solves and of solves with incompatible mass constraints
+        unsigned long long numSolves, numUnsolvable;
+        
+        /// Number of times the analytic minimizer fell back to the grid scan
+        unsigned long long numGridScanFallbacks;
+    };
+    
+    /// \brief Outcome of one solve of a batched reconstruction
+    struct Solution
+    {
+        /// Status code with the same meaning as in RecoStatus
+        unsigned status;
+        
+        /// Distance between the solution and the input missing pt (only valid for status 0)
+        double distance;
+        
+        /// Reconstructed neutrino four-momentum (only valid for status 0)
+        TLorentzVector p4Nu;
+    };
+    
 public:
     /**
      * \brief Constructor
@@ -53,6 +116,27 @@ public:
     void Reconstruct(TLorentzVector const &p4Lep, TLorentzVector const &p4B,
       TLorentzVector const &p4Miss) const;
     
+    /**
+     * \brief Reconstructs the neutrino for a batch of candidate b-jets
+     * 
+     * All candidates share the same lepton and missing pt, as in the permutation loop of the
+     * tt reconstruction, where one solve is needed per b-tagged jet. The lepton-side kinematics
+     * and rotations are computed once for the whole batch, and the per-candidate solves run in
+     * a tight loop over structure-of-arrays outputs. Results are equivalent to calling
+     * Reconstruct for each candidate; the scalar method is retained for validation.
+     */
+    void ReconstructBatch(TLorentzVector const &p4Lep, std::vector<TLorentzVector> const &p4Bs,
+      TLorentzVector const &p4Miss, std::vector<Solution> &solutions) const;
+    
+    /// \brief Returns counters accumulated since construction
+    Stats const &GetStats() const;
+    
+    /// \brief Adds the given counters to the ones of this object
+    void MergeStats(Stats const &other) const;
+    
+    /// \brief Resets the counters to zero
+    void ResetStats() const;
+    
     /**
      * \brief Reports status of reconstruction
      * 
@@ -65,13 +149,42 @@ public:
     void SetMasses(double massTop, double massW);
     
 private:
+    /**
+     * \brief Completes the reconstruction once matrix H has been found
+     * 
+     * Builds the loss and derivative forms for the measured missing pt, minimizes the distance,
+     * and stores the solution in the result members.
+     */
+    void FinishReconstruction(TLorentzVector const &p4Miss) const;
+    
     /**
      * \brief Finds the solution that is most compatible with measured missing pt
      * 
-     * Minimization algorithm exploits also the first derivative of the loss function.
+     * The returned pair contains the position of the minimum in parameter t and the corresponding
+     * value of the loss function. By default the minimum is found analytically; the iterative
+     * grid scan is kept as a fallback for degenerate configurations.
      */
     std::pair<double, double> Minimize() const;
     
+    /**
+     * \brief Finds the global minimum of the loss function analytically
+     * 
+     * The stationarity condition T'MT = 0 is a trigonometric polynomial in t, which reduces to a
+     * quartic equation in tan(t / 2). Its real roots, polished with one Newton step, provide all
+     * stationary points, and the one with the smallest loss is chosen. Returns false if no
+     * stationary point has been found, which indicates a numerically degenerate configuration.
+     */
+    bool MinimizeAnalytic(std::pair<double, double> &minimum) const;
+    
+    /**
+     * \brief Finds the global minimum of the loss function with an iterative grid scan
+     * 
+     * Approximate positions of local minima are found from sign changes of the derivative T'MT
+     * over an equidistant grid and then refined with bisection. Only used as a fallback for
+     * MinimizeAnalytic.
+     */
+    std::pair<double, double> MinimizeGridScan() const;
+    
     /**
      * \brief Constructs a rotation matrix
      * 
@@ -80,13 +193,18 @@ private:
      */
     static Matrix Rotation(unsigned axis, double angle);
     
+    /// \brief Computes the lepton-side quantities shared by all candidate b-jets
+    void PrepareLepton(TLorentzVector const &p4Lep, LeptonContext &context) const;
+    
     /**
      * \brief Solves the two mass constraints
      * 
      * Technically, matrix H is constructed (Sec. 2.5 of the paper). Returns a boolean that
-     * indicates whether the two constraints can be met simultaneously.
+     * indicates whether the two constraints can be met simultaneously. The lepton-side
+     * quantities are taken from the given precomputed context.
      */
-    bool SolveMassConstraints(TLorentzVector const &p4Lep, TLorentzVector const &p4B) const;
+    bool SolveMassConstraints(LeptonContext const &context, TLorentzVector const &p4Lep,
+      TLorentzVector const &p4B) const;
     
 private:
     /// (Squared) masses of top quark and W boson (GeV^2)
@@ -101,16 +219,22 @@ private:
     mutable Matrix H;
     
     /**
-     * \brief Matrices to compute the distance between the solution and input missing pt and the
-     * derivative of this distance with respect to the parameter
+     * \brief Trigonometric forms of the squared distance and of its derivative with respect to
+     * the parameter
      * 
-     * The squared distance and its derivative are given by T'XT and T'MT respectively.
+     * Equivalent to the forms T'XT and T'MT from Sec. 2.6.1 of the paper, with the matrices
+     * expanded into scalar coefficients. The expansion exploits at compile time the fixed
+     * structure of the error-matrix projector and of the differentiation matrix D, replacing
+     * the generic SMatrix products and Similarity evaluations in the hot path.
      */
-    mutable Matrix X, M;
+    mutable TrigForm lossForm, derivativeForm;
     
     /// Indicates whether the reconstruction has been successful
     mutable bool recoSuccess;
     
+    /// Counters describing the work done by this object
+    mutable Stats stats;
+    
     /// Distance between obtained solution for neutrino momentum and input missing pt
     mutable double distance;
     
@@ -45,9 +45,29 @@ public:
      */
     virtual void EndFile();
     
+    /**
+     * Creates a newly allocated clone of this plugin
+     * 
+     * The clone must reproduce the configuration of this plugin but must not share with it any
+     * state that changes during processing. Pointers to other plugins in the path are copied as
+     * they are; when a whole path is replicated, they are readjusted with calls to RebindPlugin.
+     * The caller takes ownership of the clone. Default implementation returns a null pointer,
+     * which indicates that the plugin cannot be cloned.
+     */
+    virtual Plugin *Clone() const;
+    
     /// Requests processing of the current event
     virtual EventOutcome ProcessEventToOutcome() = 0;
     
+    /**
+     * Replaces non-owning pointer to plugin from with a pointer to plugin to
+     * 
+     * Called for clones to redirect their pointers to other plugins from the original path to the
+     * corresponding clones. A plugin that does not depend on other plugins can rely on the
+     * default implementation, which is trivial.
+     */
+    virtual void RebindPlugin(Plugin const *from, Plugin const *to);
+    
     /// Sets non-owning pointer to an instance of Processor to which this plugin is attached
     void SetProcessor(Processor *processor);
     
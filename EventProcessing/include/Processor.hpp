@@ -2,14 +2,26 @@
 
 #include <TFile.h>
 
+#include <TreeWriteOptions.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 
+class AsyncTreeWriter;
+class DelphesReaderBase;
+class HistogramBuffer;
 class Plugin;
 
 
@@ -26,6 +38,11 @@ class Plugin;
  * 
  * When requested by user, Processor also creates an output ROOT file for each input file.
  * Arbitrary ROOT objects can be created and stored in it.
+ * 
+ * Input files can also be processed concurrently by several worker threads, which is requested
+ * with method SetNumWorkers. In that mode every worker runs its own clone of the plugin path and
+ * writes its own output files, and the queue of input files is shared among the workers. All
+ * plugins in the path must then support cloning (see Plugin::Clone).
  */
 class Processor
 {
@@ -37,22 +54,120 @@ public:
     /**
      * Constructor from a glob-like pattern that defines paths to input files
      * 
-     * Wildcards '*' and '?' are supported, and they are only allowed in the filename path.
+     * Wildcards '*' and '?' are supported, and they are only allowed in the filename path. For
+     * remote inputs, which cannot be globbed, use the iterator constructor, possibly together
+     * with ReadFileList.
      */
     Processor(std::string const &fileMask);
     
+    ~Processor();
+    
 public:
     /**
      * Creates a ROOT object (such as TTree or TH1D) in the output file
      * 
      * A ROOT object is created in the given in-file directory (use "" for the root). Arguments
-     * are directly forwarded to the constructor. The returned object is associated with the output
-     * file (with its implications for the ownership). Objects must be recreated whenever a new
-     * input file is opened.
+     * are directly forwarded to the constructor; the first of them must be the name of the
+     * object, as a C string. The returned object is associated with the output file (with its
+     * implications for the ownership). Objects must be recreated whenever a new input file is
+     * opened; with a merged output file, rebooking an existing name returns the existing
+     * object.
      */
     template<typename T, typename ... Args>
     T *Book(std::string const &inFileDirectory, Args const &... args);
     
+    /**
+     * Creates an output tree wrapped into a writer that supports asynchronous filling
+     * 
+     * The tree is created in the output file in the same way as with Book, and it follows the
+     * same lifetime: a new writer must be requested whenever a new input file is opened. The
+     * returned object is owned by Processor. Whether the filling is synchronous or asynchronous
+     * is controlled with SetAsyncOutput.
+     */
+    AsyncTreeWriter *BookAsyncTree(std::string const &inFileDirectory, std::string const &name,
+      std::string const &title);
+    
+    /**
+     * Declares a histogram backed by a plain accumulation buffer
+     * 
+     * Unlike Book, the returned handle stays valid for the whole job: filling goes into plain
+     * per-processor arrays, independent of gDirectory, and the actual ROOT histogram is
+     * materialized into the output file when each input file has been processed (with the
+     * contents merged when a single output file is written). Repeated declarations with the
+     * same directory and name return the existing handle, so plugins do not need a rebooking
+     * dance at BeginFile.
+     */
+    HistogramBuffer *BookHistogram(std::string const &inFileDirectory, std::string const &name,
+      std::string const &title, std::vector<double> const &binning);
+    
+    /// A convenience overload of BookHistogram for a uniform binning
+    HistogramBuffer *BookHistogram(std::string const &inFileDirectory, std::string const &name,
+      std::string const &title, unsigned numBins, double xMin, double xMax);
+    
+    /**
+     * Requests that output trees are filled on a dedicated writer thread
+     * 
+     * Only affects trees created with BookAsyncTree. Must be called before Run.
+     */
+    void SetAsyncOutput(bool on = true);
+    
+    /**
+     * Sets storage options for output trees created with BookAsyncTree
+     * 
+     * Controls the compression algorithm and level, basket sizes, and the auto-flush period of
+     * the trees. A per-tree summary of written and compressed bytes is printed together with
+     * the profiling report (see SetProfiling). Must be called before Run.
+     */
+    void SetTreeWriteOptions(TreeWriteOptions const &options);
+    
+    /**
+     * Enables collection and reporting of per-plugin timing statistics
+     * 
+     * For every plugin in the path, Processor accumulates the number of calls, the counts of
+     * accepted and rejected events, and the total wall time spent in
+     * Plugin::ProcessEventToOutcome, using a monotonic clock. A per-file throughput line is
+     * printed when each input file has been processed, and a per-plugin summary at the end of
+     * the job. In the multi-worker mode statistics are aggregated over all workers.
+     */
+    void SetProfiling(bool on = true);
+    
+    /**
+     * Requests that the collected timing statistics are also saved in JSON format
+     * 
+     * Implies SetProfiling. The file is written at the end of the job.
+     */
+    void SetProfileJSONOutput(std::string const &path);
+    
+    /**
+     * Reads a plain list of input files from a text file
+     * 
+     * One path or URL per line; empty lines and lines starting with '#' are skipped. The result
+     * is typically passed to the iterator constructor.
+     */
+    static std::vector<std::string> ReadFileList(std::string const &path);
+    
+    /**
+     * Enables staging of remote input files into a bounded local cache
+     * 
+     * Remote inputs (paths containing a protocol, such as root:// URLs) are copied into the
+     * given directory by a background thread, ahead of processing and overlapping with the
+     * computation, so that the event loop reads at local-disk speed. At most maxStagedFiles
+     * copies exist at a time, and a copy is deleted as soon as its file has been processed. If
+     * staging of a file fails, it is streamed directly instead. Local inputs are unaffected,
+     * and the mode applies to the sequential queue only.
+     */
+    void SetStagingCache(std::string const &directory, unsigned maxStagedFiles = 2);
+    
+    /**
+     * Requests that input files are opened ahead of time on a background thread
+     * 
+     * While the current input file is being processed, the next file in the queue is opened in
+     * the background, and the header of its Delphes tree is read, so that the switch to it
+     * becomes a near-immediate handoff. This is especially beneficial when input files are
+     * served from network storage. Must be called before Run.
+     */
+    void SetFilePrefetching(bool on = true);
+    
     /**
      * Requests automatic creation of output ROOT files
      * 
@@ -60,6 +175,16 @@ public:
      */
     void SetOutput(std::string const outputDir = "");
     
+    /**
+     * Requests that a single merged output file is written for the whole input queue
+     * 
+     * In this mode objects booked by plugins are kept alive across input files: a repeated
+     * booking with the same name returns the existing object instead of creating a new one, so
+     * histograms accumulate over all inputs and no per-file output churn or external merge step
+     * is needed. Mutually exclusive with SetOutput and with multiple workers.
+     */
+    void SetMergedOutput(std::string const &fileName);
+    
     /**
      * Registers a new plugin
      * 
@@ -71,10 +196,138 @@ public:
     /// Processes input files
     void Run();
     
+    /**
+     * Enables a persistent cache of entries accepted by the event selection
+     * 
+     * On the first run over an input file, Processor records the entries of events that pass
+     * all plugins up to and including the given boundary plugin and saves them in a sidecar
+     * file next to the input (see EntryListCache), keyed by the given tag. Subsequent runs with
+     * the same tag drive the event loop directly from the cached list, skipping rejected
+     * entries at the tree level so that their baskets are never decompressed. The tag must
+     * uniquely identify the selection configuration; stale caches for a different configuration
+     * must use a different tag. The first plugin of the path must derive from
+     * DelphesReaderBase, and the mode is not available together with pipelined reading.
+     */
+    void SetSelectionCache(std::string const &tag, Plugin const *boundaryPlugin);
+    
+    /**
+     * Requests that the reader plugin runs on a dedicated thread
+     * 
+     * In the pipelined mode the first plugin of the path, which must derive from
+     * DelphesReaderBase, decodes events on a producer thread and passes them through a bounded
+     * lock-free queue to the thread that executes the remaining plugins, so that input
+     * decompression overlaps with reconstruction. Results are identical to the sequential
+     * processing. Must be called before Run.
+     */
+    void SetPipelinedReading(bool on = true);
+    
+    /**
+     * Requests that only input files newer than their outputs are processed
+     * 
+     * An input file is skipped when its output file exists and is at least as recent as the
+     * input. Useful for topping up a campaign after a sample has been extended. Requires
+     * per-file outputs.
+     */
+    void SetIncremental(bool on = true);
+    
+    /**
+     * Requests that a restarted job resumes from where the previous one stopped
+     * 
+     * Completed input files are recorded in a journal inside the output directory, and their
+     * outputs are written through a temporary name that is only renamed to the final one when
+     * the file has been fully processed. A restarted job therefore skips inputs whose outputs
+     * are complete and transparently reprocesses the one that was interrupted. Requires
+     * per-file outputs.
+     */
+    void SetResume(bool on = true);
+    
+    /**
+     * Restricts processing to a deterministic shard of the input files
+     * 
+     * The queue of input files is partitioned round-robin into numShards equal shards, and only
+     * files of the shard with the given index are kept. Since files found through a mask are
+     * sorted, the partition is reproducible across jobs, which allows scaling a campaign over a
+     * farm without hand-rolled file lists. For splitting very large files further, see
+     * DelphesReaderBase::SetEntryRange.
+     */
+    void SetSharding(unsigned numShards, unsigned shardIndex);
+    
+    /**
+     * Sets the number of worker threads that process input files concurrently
+     * 
+     * With the default of one worker the input files are processed sequentially in the calling
+     * thread. With more workers each of them runs a clone of the plugin path, and all plugins
+     * must implement Plugin::Clone.
+     */
+    void SetNumWorkers(unsigned numWorkers);
+    
+private:
+    /// Per-plugin timing and outcome statistics
+    struct PluginStats
+    {
+        PluginStats(std::string const &name);
+        
+        /// Human-readable name of the plugin
+        std::string name;
+        
+        /// Number of calls to ProcessEventToOutcome and counts of returned outcomes
+        unsigned long long numCalls, numOk, numRejected;
+        
+        /// Total wall time spent in the plugin, in seconds
+        double wallTime;
+    };
+    
 private:
+    /// Constructor of a worker processor with an empty queue of input files
+    Processor();
+    
+    /// Creates statistics records for all plugins in the path unless already done
+    void InitializeProfile();
+    
+    /// Accumulates storage statistics of the output trees and flushes pending events
+    void CollectTreeStats();
+    
+    /// Materializes booked histogram buffers into the output file and resets them
+    void MaterializeBookedHistograms();
+    
+    /// Reads the journal of completed input files into processedInputs
+    void LoadJournal();
+    
+    /// Returns the first booking argument, which by convention is the name of the object
+    template<typename ... Args>
+    static char const *BookedObjectName(char const *name, Args const &... args);
+    
+    /// Resolves the index of the selection-cache boundary plugin in the path
+    void ResolveSelectionBoundary();
+    
+    /// Main function of the staging thread
+    void StagingLoop();
+    
+    /// Collects remote inputs and starts the staging thread
+    void StartStaging();
+    
+    /// Stops the staging thread and deletes leftover staged copies
+    void StopStaging();
+    
+    /**
+     * Runs the event loop of the current input file in the pipelined mode
+     * 
+     * Returns the number of events read from the file.
+     */
+    unsigned long long ProcessFilePipelined(DelphesReaderBase *reader);
+    
     /// Opens next input file and, if requested, creates the corresponding output file
     bool OpenNextFile();
     
+    /// Prints the per-plugin timing summary
+    void ReportProfile() const;
+    
+    /// Processes input files concurrently with multiple worker threads
+    void RunParallel();
+    
+    /// Saves the collected timing statistics in a JSON file
+    void WriteProfileJSON() const;
+    
 private:
     /// Queue of input files
     std::queue<std::string> inputFiles;
@@ -90,12 +343,111 @@ private:
     
     /// Directory in which output ROOT files will be placed
     std::string outputDir;
+    
+    /// Flag showing whether a single merged output file is written
+    bool mergedOutput;
+    
+    /// Path of the merged output file
+    std::string mergedOutputFileName;
+    
+    /// Flags for the resume and incremental modes
+    bool resumeMode, incrementalMode;
+    
+    /// Input files recorded as completed in the journal
+    std::set<std::string> processedInputs;
+    
+    /// Path of the input file being processed and final path of its output file
+    std::string curInputFileName, curOutputFileName;
+    
+    /// Number of worker threads to process input files
+    unsigned numWorkers;
+    
+    /// Flag showing whether output trees are filled asynchronously
+    bool asyncOutput;
+    
+    /// Flag showing whether input files are opened ahead of time
+    bool prefetchFiles;
+    
+    /// Configuration of the staging cache for remote inputs
+    bool stagingEnabled;
+    std::string stagingDir;
+    unsigned maxStagedFiles;
+    
+    /// Staged local copy of the current input file and its remote path; empty if none
+    std::string curStagedFile, curStagedRemote;
+    
+    /// Remote files awaiting staging, in processing order
+    std::deque<std::string> stagingQueue;
+    
+    /// Completed staging results: remote path to local copy (empty on failure)
+    std::map<std::string, std::string> stagedFiles;
+    
+    /// Remote files whose staging results must be discarded (skipped inputs)
+    std::set<std::string> discardedStaging;
+    
+    /// Flag requesting the staging thread to terminate
+    bool stagingStop;
+    
+    /// Synchronization of the staging thread
+    std::mutex stagingMutex;
+    std::condition_variable stagingCondition;
+    std::thread stagingThread;
+    
+    /// Flag showing whether the reader runs on a dedicated thread
+    bool pipelinedReading;
+    
+    /// Tag of the persistent selection cache; empty when the cache is not used
+    std::string selectionCacheTag;
+    
+    /// Boundary plugin of the selection cache and its resolved index in the path
+    Plugin const *selectionBoundary;
+    int selectionBoundaryIndex;
+    
+    /// Pending result of the background task that opens the next input file
+    std::future<TFile *> prefetchedFile;
+    
+    /// Path of the input file being opened by the background task
+    std::string prefetchedFileName;
+    
+    /// Flag showing whether per-plugin timing statistics are collected
+    bool profiling;
+    
+    /// Flag used by worker processors to delegate the final report to the parent
+    bool suppressProfileReport;
+    
+    /// Path for the JSON dump of timing statistics; empty if not requested
+    std::string profileJSONPath;
+    
+    /// Collected per-plugin statistics, aligned with the path
+    std::vector<PluginStats> pluginStats;
+    
+    /// Writers for output trees created with BookAsyncTree
+    std::vector<std::unique_ptr<AsyncTreeWriter>> asyncWriters;
+    
+    /// Histogram buffers declared with BookHistogram; kept for the whole job
+    std::vector<std::unique_ptr<HistogramBuffer>> histogramBuffers;
+    
+    /// Storage options for output trees
+    TreeWriteOptions treeWriteOptions;
+    
+    /// Accumulated per-tree statistics: uncompressed and compressed bytes written
+    std::map<std::string, std::pair<long long, long long>> treeStats;
 };
 
 
 template<typename InputIt>
 Processor::Processor(InputIt const &inputFilesBegin, InputIt const &inputFilesEnd):
-    createOutputFile(false)
+    createOutputFile(false),
+    mergedOutput(false),
+    resumeMode(false), incrementalMode(false),
+    numWorkers(1),
+    asyncOutput(false),
+    prefetchFiles(false),
+    stagingEnabled(false), maxStagedFiles(2), stagingStop(false),
+    pipelinedReading(false),
+    selectionBoundary(nullptr), selectionBoundaryIndex(-1),
+    profiling(false),
+    suppressProfileReport(false)
 {
     // Save paths to input files
     for (InputIt iter = inputFilesBegin; iter != inputFilesEnd; ++iter)
@@ -124,8 +476,41 @@ T *Processor::Book(std::string const &inFileDirectory, Args const &... args)
     d->cd();
     
     
+    // With a merged output file, plugins rebooking their objects at every BeginFile must
+    //receive the objects created for the first input file instead of duplicates. The lookup
+    //must precede the construction: histograms replace a same-name object in the directory
+    //when they register themselves, so an after-the-fact search would only find the fresh
+    //object and orphan the accumulated one.
+    if (mergedOutput)
+    {
+        TObject *existing = d->GetList()->FindObject(BookedObjectName(args...));
+        
+        if (existing)
+        {
+            T *castExisting = dynamic_cast<T *>(existing);
+            
+            if (not castExisting)
+            {
+                std::ostringstream message;
+                message << "Processor::Book: Object \"" << existing->GetName() <<
+                  "\" booked earlier has an incompatible type.";
+                throw std::runtime_error(message.str());
+            }
+            
+            return castExisting;
+        }
+    }
+    
+    
     // Create the ROOT object in the new current directory
     T *object = new T(args...);
     
     return object;
 }
+
+
+template<typename ... Args>
+char const *Processor::BookedObjectName(char const *name, Args const &...)
+{
+    return name;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+/**
+ * \class SPSCQueue
+ * 
+ * A bounded lock-free queue for a single producer and a single consumer
+ * 
+ * Implemented as a ring buffer with atomic head and tail indices; the producer only writes the
+ * tail and the consumer only the head, so no locks are needed. Elements are exchanged with
+ * std::swap, which lets the two threads recycle the storage of heavy elements (such as decoded
+ * events) instead of reallocating it: the caller's element receives whatever previously occupied
+ * the slot.
+ */
+template<typename T>
+class SPSCQueue
+{
+public:
+    /// Constructor with the maximal number of elements the queue can hold
+    SPSCQueue(std::size_t capacity):
+        buffer(capacity + 1),
+        head(0), tail(0)
+    {}
+    
+    SPSCQueue(SPSCQueue const &) = delete;
+    SPSCQueue &operator=(SPSCQueue const &) = delete;
+    
+public:
+    /**
+     * Attempts to append an element, swapping it into the queue
+     * 
+     * Returns false when the queue is full. Must only be called from the producer thread.
+     */
+    bool TryPush(T &element)
+    {
+        std::size_t const t = tail.load(std::memory_order_relaxed);
+        std::size_t const next = Increment(t);
+        
+        if (next == head.load(std::memory_order_acquire))
+            return false;
+        
+        std::swap(buffer[t], element);
+        tail.store(next, std::memory_order_release);
+        
+        return true;
+    }
+    
+    /**
+     * Attempts to extract the oldest element, swapping it out of the queue
+     * 
+     * Returns false when the queue is empty. Must only be called from the consumer thread.
+     */
+    bool TryPop(T &element)
+    {
+        std::size_t const h = head.load(std::memory_order_relaxed);
+        
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        
+        std::swap(buffer[h], element);
+        head.store(Increment(h), std::memory_order_release);
+        
+        return true;
+    }
+    
+private:
+    /// Advances a ring-buffer index by one position
+    std::size_t Increment(std::size_t index) const
+    {
+        return (index + 1) % buffer.size();
+    }
+    
+private:
+    /// Storage for the elements
+    std::vector<T> buffer;
+    
+    /// Indices of the oldest element and of the next free slot
+    std::atomic<std::size_t> head, tail;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <DelphesReaderBase.hpp>
+
+#include <SkimWriter.hpp>
+
+
+/**
+ * \class SkimReader
+ * 
+ * A plugin that reads compact skims produced by SkimWriter
+ * 
+ * This is a drop-in replacement of class DelphesReader for running over skims. The flat arrays
+ * of the skim are translated into the standard collections of Delphes objects, with only the
+ * fields stored in the skim set (in case of LHE particles, the four-momentum components are
+ * recomputed from the stored kinematics). The kinematic selection on jets is re-applied, which
+ * allows tightening it with respect to the one used when the skim was produced. LHE weights are
+ * not stored in skims and cannot be read.
+ */
+class SkimReader: public DelphesReaderBase
+{
+public:
+    /// Constructor that defines kinematic selection applied to jets
+    SkimReader(double jetPtThreshold = 20., double jetEtaThreshold = 2.4);
+    
+    virtual ~SkimReader() = default;
+    
+public:
+    /**
+     * Creates a clone of this plugin with the same configuration
+     * 
+     * Implemented from Plugin.
+     */
+    virtual Plugin *Clone() const override;
+    
+    /// Returns collection of electrons
+    virtual std::vector<Electron> const &GetElectrons() const override;
+    
+    /// Returns collection of muons
+    virtual std::vector<Muon> const &GetMuons() const override;
+    
+    /**
+     * Returns collection of jets
+     * 
+     * Only jets that meet the kinematic selection are included in the collection.
+     */
+    virtual std::vector<Jet> const &GetJets() const override;
+    
+    /// Returns missing pt
+    virtual MissingET const &GetMissPt() const override;
+    
+    /**
+     * Returns nominal per-event weight
+     * 
+     * Reimplemented from DelphesReaderBase since skims store the weight in a plain branch.
+     */
+    virtual double GetWeight() const override;
+    
+protected:
+    /// Builds the event collections from the skim buffers
+    virtual void ReadEvent() override;
+    
+    /// Sets up buffers to read the skim tree
+    virtual void SetupBuffers() override;
+    
+private:
+    /// Maximal supported number of objects per collection, matching SkimWriter
+    static int const maxSize = SkimWriter::maxSize;
+    
+    /// Collections of the current event
+    std::vector<Electron> electrons;
+    std::vector<Muon> muons;
+    std::vector<Jet> jets;
+    
+    /// Missing pt of the current event
+    MissingET met;
+    
+    // Buffers to read the skim tree
+    Float_t bfWeight;
+    
+    Int_t bfNumEle;
+    Float_t bfElePt[maxSize], bfEleEta[maxSize], bfElePhi[maxSize];
+    Int_t bfEleCharge[maxSize];
+    
+    Int_t bfNumMu;
+    Float_t bfMuPt[maxSize], bfMuEta[maxSize], bfMuPhi[maxSize];
+    Int_t bfMuCharge[maxSize];
+    
+    Int_t bfNumJet;
+    Float_t bfJetPt[maxSize], bfJetEta[maxSize], bfJetPhi[maxSize], bfJetMass[maxSize];
+    UInt_t bfJetBTag[maxSize];
+    
+    Float_t bfMetPt, bfMetPhi;
+    
+    Int_t bfNumLHE;
+    Int_t bfLHEPid[maxSize], bfLHEMother[maxSize];
+    Float_t bfLHEPt[maxSize], bfLHEEta[maxSize], bfLHEPhi[maxSize], bfLHEMass[maxSize];
+};
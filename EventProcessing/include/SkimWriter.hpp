@@ -0,0 +1,81 @@
+#pragma once
+
+#include <AnalysisPlugin.hpp>
+
+#include <DelphesReaderBase.hpp>
+
+
+class TTree;
+
+
+/**
+ * \class SkimWriter
+ * 
+ * A plugin that writes selected events into a compact flat skim
+ * 
+ * The skim contains only the quantities consumed in reconstruction studies: the per-event
+ * weight, charged leptons, jets passing the kinematic selection, missing pt, and a minimal
+ * subset of the LHE record. Everything is stored as plain contiguous arrays, without
+ * TClonesArray containers, and the branches are compressed with LZ4, so that the resulting
+ * files are much smaller and decode an order of magnitude faster than the original Delphes
+ * output. Skims are read back with the drop-in reader plugin SkimReader.
+ */
+class SkimWriter: public AnalysisPlugin
+{
+public:
+    /// Maximal supported number of objects per collection
+    static int const maxSize = 256;
+    
+public:
+    /// Constructor from a pointer to reader plugin
+    SkimWriter(DelphesReaderBase const *reader);
+    
+public:
+    virtual void BeginFile(TFile *) override;
+    
+    /**
+     * Creates a clone of this plugin
+     * 
+     * Implemented from Plugin.
+     */
+    virtual Plugin *Clone() const override;
+    
+    /**
+     * Redirects pointer to the reader plugin
+     * 
+     * Reimplemented from Plugin.
+     */
+    virtual void RebindPlugin(Plugin const *from, Plugin const *to) override;
+    
+private:
+    /// Copies the current event into the output buffers and fills the tree
+    virtual bool ProcessEvent() override;
+    
+private:
+    /// Non-owning pointer to reader plugin
+    DelphesReaderBase const *reader;
+    
+    /// Non-owning pointer to output tree
+    TTree *outTree;
+    
+    // Buffers to fill the tree
+    Float_t bfWeight;
+    
+    Int_t bfNumEle;
+    Float_t bfElePt[maxSize], bfEleEta[maxSize], bfElePhi[maxSize];
+    Int_t bfEleCharge[maxSize];
+    
+    Int_t bfNumMu;
+    Float_t bfMuPt[maxSize], bfMuEta[maxSize], bfMuPhi[maxSize];
+    Int_t bfMuCharge[maxSize];
+    
+    Int_t bfNumJet;
+    Float_t bfJetPt[maxSize], bfJetEta[maxSize], bfJetPhi[maxSize], bfJetMass[maxSize];
+    UInt_t bfJetBTag[maxSize];
+    
+    Float_t bfMetPt, bfMetPhi;
+    
+    Int_t bfNumLHE;
+    Int_t bfLHEPid[maxSize], bfLHEMother[maxSize];
+    Float_t bfLHEPt[maxSize], bfLHEEta[maxSize], bfLHEPhi[maxSize], bfLHEMass[maxSize];
+};
@@ -2,15 +2,14 @@
 
 #include <AnalysisPlugin.hpp>
 
+#include <CounterRNG.hpp>
 #include <DelphesReaderBase.hpp>
 
-#include <TRandom3.h>
-
 #include <string>
 #include <vector>
 
 
-class TH1;
+class HistogramBuffer;
 
 
 /**
@@ -24,6 +23,11 @@ class TH1;
  * variations, it creates a histogram for each provided alternative LHE weight and also a pair of
  * histograms for a scale variation in the smeared mtt (which approximates a variation due to a
  * jet momentum scale uncertainty).
+ * 
+ * Filling of the histograms with alternative weights is batched: the bin is determined once per
+ * event, and the whole vector of weights is added into a contiguous accumulation array with a
+ * vectorizable loop. The histograms themselves are only materialized when the input file has
+ * been processed.
  */
 class SystMttHists: public AnalysisPlugin
 {
@@ -36,7 +40,25 @@ public:
       double resolution, double scaleVariation = 0.01);
     
 public:
-    virtual void BeginFile(TFile *) override;
+    virtual void BeginFile(TFile *inputFile) override;
+    
+    /**
+     * Creates a clone of this plugin with the same configuration
+     * 
+     * Implemented from Plugin. Cloning is safe since the smearing uses per-event
+     * random-number streams.
+     */
+    virtual Plugin *Clone() const override;
+    
+    /// Materializes histograms with alternative weights from the accumulated sums
+    virtual void EndFile() override;
+    
+    /**
+     * Redirects pointer to the reader plugin
+     * 
+     * Reimplemented from Plugin.
+     */
+    virtual void RebindPlugin(Plugin const *from, Plugin const *to) override;
     
 private:
     /// Fills nominal histogram and histograms for systematic variations
@@ -47,7 +69,10 @@ private:
     DelphesReaderBase const *reader;
     
     /// Random-number generator used for smearing
-    TRandom3 rGen;
+    CounterRNG rGen;
+    
+    /// Key of the current input file for the per-event random-number streams
+    unsigned long long fileKey;
     
     /// Binning for mtt histograms
     std::vector<double> binning;
@@ -58,15 +83,23 @@ private:
     /// Scale variation for mtt
     double scaleVariation;
     
-    /// Non-owning pointer to nominal histogram
-    TH1 *histNominal;
+    /// Non-owning handle of the nominal histogram
+    HistogramBuffer *histNominal;
     
-    /// Non-owning pointers to histograms with varied mtt scale
-    TH1 *histScaleUp, *histScaleDown;
+    /// Non-owning handles of histograms with varied mtt scale
+    HistogramBuffer *histScaleUp, *histScaleDown;
     
-    /// Non-owning pointers to histograms with alternative LHE weights
-    std::vector<TH1 *> histAltWeights;
+    /// IDs of alternative LHE weights, learned from the first event of the current file
+    std::vector<int> altWeightIDs;
+    
+    /**
+     * Accumulated sums of alternative weights
+     * 
+     * Flat array of dimensions (number of bins, including under- and overflow) x (number of
+     * weights), in bin-major order.
+     */
+    std::vector<double> altWeightSums;
     
-    /// Indicates whether hitograms with alternative weights have been booked
-    bool histAltWeightsBooked;
+    /// Number of events accumulated in the current file
+    unsigned long long numEventsInFile;
 };
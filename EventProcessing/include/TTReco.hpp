@@ -5,6 +5,8 @@
 #include <DelphesReaderBase.hpp>
 #include <NuReco.hpp>
 
+#include <array>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -30,6 +32,150 @@ class TH2;
  */
 class TTReco: public AnalysisPlugin
 {
+private:
+    /**
+     * Flattened representation of a uniformly binned 1D likelihood histogram
+     * 
+     * Stores precomputed logarithms of the (normalized) bin contents in a contiguous array, so
+     * that the evaluation in the hot permutation loop amounts to one multiplication and one array
+     * load instead of virtual histogram calls and a logarithm.
+     */
+    struct LogLikelihood1D
+    {
+        /// Fills the table from the given histogram, which must be uniformly binned
+        void Initialize(TH1 const &hist);
+        
+        /**
+         * Evaluates the tabulated log-likelihood at the given point
+         * 
+         * Returns false if the point falls into the overflow bin, mirroring the treatment of
+         * overflows in the original histogram-based evaluation. Underflows are tabulated.
+         */
+        bool Evaluate(double x, double &logValue) const;
+        
+        /// Lower edge of the axis and inverse bin width
+        double xMin, invBinWidth;
+        
+        /// Number of regular bins
+        int numBins;
+        
+        /// Logarithms of bin contents, with the underflow bin at index 0
+        std::vector<double> logContents;
+    };
+    
+    /// Cached neutrino solution for one jet tried as the b quark of the semileptonic decay
+    struct NuSolution
+    {
+        NuSolution(): status(0)
+        {}
+        
+        /// 0: not yet tried, 1: solved, 2: unusable
+        int status;
+        
+        /**
+         * Log-likelihoods of the neutrino reconstruction, one per likelihood set
+         * 
+         * Only valid for status 1. Negative infinity marks a distance outside of the range of
+         * the corresponding likelihood.
+         */
+        std::vector<double> logLikelihoods;
+        
+        /// Reconstructed neutrino four-momentum (only valid for status 1)
+        TLorentzVector p4Nu;
+    };
+    
+    /// Flattened representation of a uniformly binned 2D likelihood histogram
+    struct LogLikelihood2D
+    {
+        /// Fills the table from the given histogram, which must be uniformly binned
+        void Initialize(TH2 const &hist);
+        
+        /**
+         * Evaluates the tabulated log-likelihood at the given point
+         * 
+         * Returns false if the point falls into an overflow bin along either axis.
+         */
+        bool Evaluate(double x, double y, double &logValue) const;
+        
+        /**
+         * Returns an upper bound of the log-likelihood over the first axis at the given second
+         * coordinate
+         * 
+         * Used to discard whole slices of permutations. Returns false if the coordinate falls
+         * into the overflow bin.
+         */
+        bool EvaluateMaxOverX(double y, double &logValue) const;
+        
+        /// Lower edges of the axes and inverse bin widths
+        double xMin, invBinWidthX, yMin, invBinWidthY;
+        
+        /// Numbers of regular bins
+        int numBinsX, numBinsY;
+        
+        /// Logarithms of bin contents in row-major order, with underflow bins at index 0
+        std::vector<double> logContents;
+        
+        /// Per-bin maxima of the log-likelihood over the first axis, with the underflow first
+        std::vector<double> maxLogOverX;
+        
+        /// Second coordinate of the global maximum of the likelihood
+        double peakY;
+    };
+    
+    /// Counters describing the combinatorial work done by this plugin
+    struct Stats
+    {
+        Stats():
+            numEvents(0), numPermutationsTried(0), numSubtreesPruned(0), numPairsPruned(0)
+        {
+            jetMultiplicity.fill(0);
+        }
+        
+        /// Number of reconstructed events (including re-runs for selection hypotheses)
+        unsigned long long numEvents;
+        
+        /// Number of evaluated permutations and of subtrees skipped by the pruning
+        unsigned long long numPermutationsTried, numSubtreesPruned;
+        
+        /// Number of light-jet pairs discarded by the per-pair likelihood bound
+        unsigned long long numPairsPruned;
+        
+        /// Distribution of the selected-jet multiplicity; the last bin is inclusive
+        std::array<unsigned long long, 17> jetMultiplicity;
+    };
+    
+    /// One likelihood definition with its lookup tables
+    struct LikelihoodSet
+    {
+        /// Name used to label results of this likelihood
+        std::string name;
+        
+        /// Lookup tables that define the likelihood function
+        LogLikelihood1D nuDist;
+        LogLikelihood2D massHad;
+        
+        /// Logarithm of the maximal bin content of massHad, used for pruning
+        double maxLogLikelihoodMassHad;
+    };
+    
+    /// Best interpretation of the current event for one likelihood set
+    struct Interpretation
+    {
+        Interpretation():
+            rank(-std::numeric_limits<double>::infinity()),
+            bTopLep(nullptr), bTopHad(nullptr), q1TopHad(nullptr), q2TopHad(nullptr)
+        {}
+        
+        /// Rank of the interpretation; negative infinity when reconstruction failed
+        double rank;
+        
+        /// Non-owning pointers to jets identified as decay products of the top quarks
+        Jet const *bTopLep, *bTopHad, *q1TopHad, *q2TopHad;
+        
+        /// Reconstructed neutrino four-momentum
+        TLorentzVector p4Nu;
+    };
+    
 public:
     /// Jets to be identified in the final state of a ttbar system
     enum class DecayJet
@@ -45,26 +191,64 @@ public:
     TTReco(DelphesReaderBase const *reader, LJetsSelection const *selector,
       std::string const &likelihoodFile);
     
+    ~TTReco();
+    
 public:
+    /**
+     * Adds an alternative likelihood definition evaluated in the same pass
+     * 
+     * Every permutation is ranked against all registered likelihoods at once, so evaluating
+     * alternative likelihoods costs only the two extra lookups per permutation instead of a
+     * separate job. Results for the additional likelihoods are retrieved by passing their
+     * index (in order of registration, starting from 1) to the accessors; index 0 refers to
+     * the likelihood given to the constructor. Must be called before processing starts.
+     */
+    void AddLikelihood(std::string const &name, std::string const &likelihoodFile);
+    
+    /**
+     * Creates a clone of this plugin
+     * 
+     * Implemented from Plugin.
+     */
+    virtual Plugin *Clone() const override;
+    
     /**
      * Returns jet corresponding to the given quark in the final state tt -> blv bqq
      * 
-     * The behaviour is undefined if reconstruction has failed.
+     * The behaviour is undefined if reconstruction has failed for the given likelihood.
      */
-    Jet const &GetJet(DecayJet type) const;
+    Jet const &GetJet(DecayJet type, unsigned iLikelihood = 0) const;
     
     /// Returns four-momentum of the charged lepton from the t->blv decay
     TLorentzVector const &GetLeptonP4() const;
     
+    /// Returns name of the likelihood with the given index
+    std::string const &GetLikelihoodName(unsigned iLikelihood) const;
+    
     /// Returns four-momentum of reconstructed neutrino from the t->blv decay
-    TLorentzVector const &GetNeutrinoP4() const;
+    TLorentzVector const &GetNeutrinoP4(unsigned iLikelihood = 0) const;
+    
+    /// Returns the number of registered likelihoods
+    unsigned GetNumLikelihoods() const;
     
     /**
      * Returns rank of the accepted interpretation of the current event
      * 
-     * If reconstruction has failed, returns -infinity.
+     * If reconstruction has failed for the given likelihood, returns -infinity.
      */
-    double GetRank() const;
+    double GetRank(unsigned iLikelihood = 0) const;
+    
+    /**
+     * Performs reconstruction of the current event with the given jet selection
+     * 
+     * Re-runs the jet assignment for the event currently held by the reader, considering only
+     * jets that pass the given selection, and makes the outcome available through the usual
+     * accessors. Neutrino solutions are cached per jet within the event, so evaluating several
+     * selection hypotheses for the same event (as done in the cut-scan mode of TTRecoPerf) only
+     * repeats the cheap permutation ranking. The standard per-event processing is equivalent to
+     * calling this method with the selection set by SetJetSelection.
+     */
+    void ReconstructEvent(double minPtCut, double maxAbsEtaCut) const;
     
     /**
      * Returns status code showing whether the reconstruction has succeeded
@@ -74,10 +258,19 @@ public:
     unsigned GetRecoStatus() const;
     
     /// Computes and returns four-momentum of reconstructed leptonically decaying top quark
-    TLorentzVector GetTopLepP4() const;
+    TLorentzVector GetTopLepP4(unsigned iLikelihood = 0) const;
     
     /// Computes and returns four-momentum of reconstructed hadronically decaying top quark
-    TLorentzVector GetTopHadP4() const;
+    TLorentzVector GetTopHadP4(unsigned iLikelihood = 0) const;
+    
+    /**
+     * Prints a summary of the combinatorial and solver statistics
+     * 
+     * Covers the permutation counters of this plugin and the counters of the embedded neutrino
+     * reconstruction. In the multi-worker mode statistics of the clones are merged into the
+     * original plugin when the clones are destroyed.
+     */
+    void PrintStats() const;
     
     /**
      *  Sets jet selection
@@ -86,7 +279,17 @@ public:
      */
     void SetJetSelection(double minPt, double maxAbsEta = std::numeric_limits<double>::infinity());
     
+    /**
+     * Redirects pointers to the reader and selection plugins
+     * 
+     * Reimplemented from Plugin.
+     */
+    virtual void RebindPlugin(Plugin const *from, Plugin const *to) override;
+    
 private:
+    /// Loads a likelihood definition from the given file
+    static LikelihoodSet LoadLikelihood(std::string const &name, std::string const &fileName);
+    
     /**
      * Performs reconstruction of the current event
      * 
@@ -108,12 +311,46 @@ private:
     /// Non-owning pointer to plugin that performs event selection
     LJetsSelection const *selector;
     
+    /// Non-owning pointer to the original plugin; null unless this object is a clone
+    TTReco *statsParent;
+    
+    /// Counters describing the combinatorial work
+    mutable Stats stats;
+    
     /// Object that performs reconstruction of neutrino
     NuReco nuReco;
     
-    /// Histograms that define likelihood function
-    TH1 *likelihoodNuDist;
-    TH2 *likelihoodMassHad;
+    /**
+     * Cached neutrino solutions for the current event, indexed by jet
+     * 
+     * Reset at the start of the per-event processing and shared by all selection hypotheses
+     * evaluated for the event.
+     */
+    mutable std::vector<NuSolution> nuCache;
+    
+    
+    /**
+     * Scratch buffers for batched neutrino reconstruction
+     * 
+     * Only used in the method ReconstructEvent but placed here to avoid reallocation of memory
+     * for each event.
+     */
+    mutable std::vector<unsigned> batchJetIndices;
+    mutable std::vector<TLorentzVector> batchJetP4s;
+    mutable std::vector<NuReco::Solution> batchSolutions;
+    
+    /**
+     * Scratch buffers of the permutation loop
+     * 
+     * Positions (within selectedJetIndices) of b-tagged candidates and packed indices of the
+     * light-jet pairs, ordered so that pairs with masses close to the W peak of the likelihood
+     * are tried first. Only used in the method ReconstructEvent.
+     */
+    mutable std::vector<unsigned> bCandidates;
+    mutable std::vector<unsigned> orderedPairs;
+    
+    /// Registered likelihood definitions, with the one from the constructor at index 0
+    std::vector<LikelihoodSet> likelihoods;
     
     /// Kinematic selection for jets
     double minPt, maxAbsEta;
@@ -124,29 +361,38 @@ private:
      * This vector is only used in the method ProcessEvent but placed here to avoid reallocation of
      * memory for each event.
      */
-    std::vector<unsigned> selectedJetIndices;
+    mutable std::vector<unsigned> selectedJetIndices;
     
     /**
-     * Status code indicating success of failure of reconstruction
+     * Cached four-momenta of the selected jets
      * 
-     * Code 0 indicates a successful reconstruction. Other values denote failures and describe
-     * their reasons.
+     * Indexed in the same way as selectedJetIndices. Like that vector, only used in the method
+     * ProcessEvent but placed here to avoid reallocation of memory for each event.
+     */
+    mutable std::vector<TLorentzVector> jetP4s;
+    
+    /**
+     * Cached four-momenta and masses of dijet combinations
+     * 
+     * For indices i < j into selectedJetIndices, element i * n + j, where n is the number of
+     * selected jets, describes the sum of the corresponding two jet momenta. Remaining elements
+     * are not filled. Only used in the method ProcessEvent.
      */
-    unsigned recoStatus;
+    mutable std::vector<TLorentzVector> dijetP4s;
+    mutable std::vector<double> dijetMasses;
     
     /**
-     * Rank of the best interpretation constructed so far
+     * Status code indicating success of failure of reconstruction
      * 
-     * When reconstruction of a new event starts, this variable is reset to -infinity. After all
-     * interpretations in an event have been considered, it contains the rank of the best
-     * interpretation.
+     * Code 0 indicates a successful reconstruction. Other values denote failures and describe
+     * their reasons.
      */
-    double highestRank;
+    mutable unsigned recoStatus;
     
     /**
-     * Non-owning pointers to jets identified as decay products of the top quarks
+     * Best interpretations of the current event, one per likelihood set
      * 
-     * Pointers refer to jets in the collection provided by the jet reader.
+     * Jet pointers refer to the collection provided by the jet reader.
      */
-    Jet const *bTopLep, *bTopHad, *q1TopHad, *q2TopHad;
+    mutable std::vector<Interpretation> interpretations;
 };
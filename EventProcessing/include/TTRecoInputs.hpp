@@ -3,9 +3,11 @@
 #include <AnalysisPlugin.hpp>
 
 #include <DelphesReaderBase.hpp>
+#include <JetMatcher.hpp>
 #include <NuReco.hpp>
 
 #include <string>
+#include <vector>
 
 #include <TFile.h>
 #include <TH1D.h>
@@ -26,6 +28,10 @@ class LJetsSelection;
  * for the semileptonic leg of the decay, and for the hadronic leg it fills a 2D histogram of
  * masses of the top quark and the W boson computed from reconstructed jets. The histograms are
  * combined over all input files and stored in a ROOT file.
+ * 
+ * The plugin supports cloning for concurrent processing: clones accumulate into thread-local
+ * histograms, which are merged into the original plugin, together with the event counters, when
+ * the clones are destroyed. Only the original plugin writes the output file.
  */
 class TTRecoInputs: public AnalysisPlugin
 {
@@ -37,17 +43,26 @@ public:
     ~TTRecoInputs();
     
 public:
+    /**
+     * Creates a clone of this plugin with thread-local histograms
+     * 
+     * Implemented from Plugin.
+     */
+    virtual Plugin *Clone() const override;
+    
     /// Prints a summary of event counts
     void PrintCounts() const;
     
-private:
     /**
-     * Matches a reconstructed jet to the given GenParticle
+     * Redirects pointers to the reader and selection plugins
      * 
-     * Matching is done by dR. If not match with dR less than the given threshold is found, a null
-     * pointer is returned.
+     * Reimplemented from Plugin.
      */
-    Jet const *MatchJet(GenParticle const *p, double maxDR = 0.2) const;
+    virtual void RebindPlugin(Plugin const *from, Plugin const *to) override;
+    
+private:
+    /// Constructor of a clone that accumulates into thread-local histograms
+    TTRecoInputs(TTRecoInputs *parent);
     
     /// Selects suitable events and fills the histograms
     virtual bool ProcessEvent() override;
@@ -71,6 +86,16 @@ private:
     /// An object to perform neutrino reconstruction
     NuReco nuReco;
     
+    /// Engine that matches quarks to reconstructed jets
+    JetMatcher matcher;
+    
+    /// Scratch buffers for the matching
+    std::vector<GenParticle const *> matchQueries;
+    std::vector<Jet const *> matchedJets;
+    
+    /// Non-owning pointer to the original plugin; null unless this object is a clone
+    TTRecoInputs *parent;
+    
     /// Event counters for sanity checks
     unsigned long long nVisited, nTargetLHE, nReconstructable, nFilled;
 };
@@ -3,9 +3,12 @@
 #include <AnalysisPlugin.hpp>
 
 #include <DelphesReaderBase.hpp>
+#include <JetMatcher.hpp>
 #include <TTReco.hpp>
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <TFile.h>
 #include <TProfile.h>
@@ -20,6 +23,13 @@
  * resolution of reconstructed mtt and the efficiency of identification of all four jets. All
  * quantities are computed in bins of parton-level mtt. The histograms are constructed from all
  * input files and stored in a single ROOT file.
+ * 
+ * In addition, a grid of jet selection working points can be evaluated in the same pass with
+ * AddSelectionHypothesis. The jet-parton matching is done once per event, and the
+ * reconstruction is re-ranked for every hypothesis against the neutrino solutions cached by
+ * TTReco, which is far cheaper than a dedicated job per working point. Since the re-ranking
+ * overwrites the state of the TTReco plugin, in this mode TTRecoPerf must be the last plugin in
+ * the path that consumes reconstruction results.
  */
 class TTRecoPerf: public AnalysisPlugin
 {
@@ -31,18 +41,18 @@ public:
     ~TTRecoPerf();
     
 public:
-    /// Prints a summary of event counts
-    void PrintCounts() const;
-    
-private:
     /**
-     * Matches a reconstructed jet to the given GenParticle
+     * Adds a jet selection working point to evaluate in the same pass
      * 
-     * Matching is done by dR. If not match with dR less than the given threshold is found, a null
-     * pointer is returned.
+     * The selection must be tighter than (or equal to) the one configured on the TTReco plugin
+     * itself with SetJetSelection.
      */
-    Jet const *MatchJet(GenParticle const *p, double maxDR = 0.2) const;
+    void AddSelectionHypothesis(double minPt, double maxAbsEta);
     
+    /// Prints a summary of event counts
+    void PrintCounts() const;
+    
+private:
     /// Selects suitable events and fills the histograms
     virtual bool ProcessEvent() override;
     
@@ -53,6 +63,13 @@ private:
     /// Non-owning pointer to a plugin that performs tt reconstruction
     TTReco const *ttReco;
     
+    /// Engine that matches quarks to reconstructed jets
+    JetMatcher matcher;
+    
+    /// Scratch buffers for the matching
+    std::vector<GenParticle const *> matchQueries;
+    std::vector<Jet const *> matchedJets;
+    
     /// Output ROOT file
     TFile outputFile;
     
@@ -62,6 +79,22 @@ private:
     /// Profile of squared mtt bias, which is needed to compute mtt resolution
     TProfile profBias2;
     
+    /// One jet selection working point of the cut scan with its profiles
+    struct Hypothesis
+    {
+        /// Jet selection defining the working point
+        double minPt, maxAbsEta;
+        
+        /// Suffix appended to names of objects of this working point
+        std::string suffix;
+        
+        /// Profiles analogous to the default ones, named with the working-point suffix
+        std::unique_ptr<TProfile> profBias, profEfficiency, profBias2;
+    };
+    
+    /// Working points evaluated in the cut scan
+    std::vector<Hypothesis> hypotheses;
+    
     /// Event counters for sanity checks
     unsigned long long nVisited, nTargeted, nReconstructable;
 };
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <AnalysisPlugin.hpp>
+
+#include <VarsReader.hpp>
+
+#include <string>
+#include <vector>
+
+#include <TFile.h>
+
+
+class TH1;
+
+
+/**
+ * \class TemplateBuilder
+ * 
+ * A plugin that builds binned mtt templates for a grid of reweighting points
+ * 
+ * For every event of the input ntuples, the plugin fills a template of the reconstructed (or
+ * smeared) mass of the tt system for the nominal weight and for every registered reweighting
+ * point. A point is described by a weight curve as a function of the parton-level mtt, typically
+ * produced by the analysis tooling for one point of a (mA, tan beta) grid; the curves are
+ * flattened into lookup tables, so the per-event cost of a point is one multiplication and two
+ * accumulations. All templates are built in a single pass over the ntuples and written into one
+ * output file, replacing the per-point passes of the Python tooling.
+ * 
+ * The plugin supports cloning for concurrent processing: clones accumulate into thread-local
+ * arrays, which are merged into the original plugin when they are destroyed.
+ */
+class TemplateBuilder: public AnalysisPlugin
+{
+public:
+    /// Constructor with the template binning and a name for the output file
+    TemplateBuilder(VarsReader const *reader, std::vector<double> const &binning,
+      std::string const &outFileName);
+    
+    ~TemplateBuilder();
+    
+public:
+    /**
+     * Registers a reweighting point with the given weight curve
+     * 
+     * The curve gives the event weight as a function of the parton-level mtt and must be
+     * uniformly binned; values outside of its range are clamped to the edge bins. Must be
+     * called before processing starts.
+     */
+    void AddReweightedPoint(std::string const &name, TH1 const &weightCurve);
+    
+    /**
+     * Registers one reweighting point per histogram found in the given file
+     * 
+     * The histogram names are used as the point names.
+     */
+    void AddReweightedPointsFromFile(std::string const &weightFileName);
+    
+    /// Checks that the inputs provide what the registered points need
+    virtual void BeginFile(TFile *) override;
+    
+    /**
+     * Creates a clone of this plugin with thread-local accumulation arrays
+     * 
+     * Implemented from Plugin.
+     */
+    virtual Plugin *Clone() const override;
+    
+    /**
+     * Redirects pointer to the reader plugin
+     * 
+     * Reimplemented from Plugin.
+     */
+    virtual void RebindPlugin(Plugin const *from, Plugin const *to) override;
+    
+    /**
+     * Sets a scale factor applied to all templates
+     * 
+     * Typically the k-factor times the selection efficiency over the number of generated
+     * events.
+     */
+    void SetScaleFactor(double scaleFactor);
+    
+private:
+    /// Flattened weight curve of one reweighting point
+    struct WeightCurve
+    {
+        /// Name of the point, used for the template
+        std::string name;
+        
+        /// Lower edge of the axis and inverse bin width
+        double xMin, invBinWidth;
+        
+        /// Weight values per bin
+        std::vector<double> values;
+    };
+    
+private:
+    /// Constructor of a clone that accumulates into thread-local arrays
+    TemplateBuilder(TemplateBuilder *parent);
+    
+    /// Evaluates a weight curve, clamping the argument to its range
+    static double EvaluateCurve(WeightCurve const &curve, double x);
+    
+    /// Accumulates the current event into the templates
+    virtual bool ProcessEvent() override;
+    
+private:
+    /// Non-owning pointer to reader plugin
+    VarsReader const *reader;
+    
+    /// Output ROOT file; not opened in clones
+    TFile outputFile;
+    
+    /// Binning of the templates
+    std::vector<double> binning;
+    
+    /// Registered reweighting points
+    std::vector<WeightCurve> points;
+    
+    /// Scale factor applied to all templates
+    double scaleFactor;
+    
+    /**
+     * Accumulated sums of weights and of squared weights
+     * 
+     * Flat arrays of dimensions (number of bins, including under- and overflow) x (number of
+     * points plus one), in bin-major order, with the nominal weight at point index 0.
+     */
+    std::vector<double> sums, sums2;
+    
+    /// Non-owning pointer to the original plugin; null unless this object is a clone
+    TemplateBuilder *parent;
+};
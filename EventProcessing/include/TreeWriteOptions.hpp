@@ -0,0 +1,43 @@
+#pragma once
+
+
+class TBranch;
+class TTree;
+
+
+/**
+ * \class TreeWriteOptions
+ * 
+ * Storage settings for output trees
+ * 
+ * Collects the knobs that control how output trees are laid out on disk: the compression
+ * algorithm and level (from ROOT::ECompressionAlgorithm; for instance LZ4 for scratch files and
+ * LZMA for archival), the basket size of the branches, and the auto-flush period. Unset fields,
+ * marked with negative values, leave the corresponding ROOT defaults untouched.
+ */
+class TreeWriteOptions
+{
+public:
+    /// Constructor leaves all settings at their ROOT defaults
+    TreeWriteOptions();
+    
+public:
+    /// Applies the branch-level settings to a newly created branch
+    void Apply(TBranch &branch) const;
+    
+    /// Applies the tree-level settings
+    void Apply(TTree &tree) const;
+    
+    /// Returns the basket size to use at branch creation, or the given default
+    int BasketSize(int defaultSize) const;
+    
+public:
+    /// Compression algorithm (a value of ROOT::ECompressionAlgorithm) and level; -1 to not set
+    int compressionAlgorithm, compressionLevel;
+    
+    /// Basket size of the branches, in bytes; -1 to not set
+    int basketSize;
+    
+    /// Auto-flush period, in entries; -1 to not set
+    long long autoFlush;
+};
@@ -5,13 +5,19 @@
 #include <DelphesReaderBase.hpp>
 #include <TTReco.hpp>
 
-#include <TTree.h>
+#include <vector>
+
+
+class AsyncTreeWriter;
 
 
 /**
  * \class VarWriter
  * 
  * A pluging to compute various observables and store them in ROOT trees
+ * 
+ * When the reconstruction plugin carries several likelihood definitions, a separate set of
+ * branches, suffixed with the likelihood name, is written for every additional likelihood.
  */
 class VarWriter: public AnalysisPlugin
 {
@@ -21,6 +27,20 @@ public:
 public:
     virtual void BeginFile(TFile *) override;
     
+    /**
+     * Creates a clone of this plugin with the same configuration
+     * 
+     * Implemented from Plugin.
+     */
+    virtual Plugin *Clone() const override;
+    
+    /**
+     * Redirects pointers to the reader and reconstruction plugins
+     * 
+     * Reimplemented from Plugin.
+     */
+    virtual void RebindPlugin(Plugin const *from, Plugin const *to) override;
+    
     /// Requests storing of some parton-level observables
     void StorePartonLevel(bool on = true);
     
@@ -37,11 +57,14 @@ private:
     /// Flag showing whether parton-level variables should be stored
     bool storePartonLevel;
     
-    /// Non-owning pointer to output tree
-    TTree *outTree;
+    /// Non-owning pointer to writer of the output tree
+    AsyncTreeWriter *outTree;
     
     // Buffers to fill the tree
     Float_t bfWeight;
     Float_t bfPtTopLep, bfPtTopHad, bfMassTT;
     Float_t bfPartonMassTT;
+    
+    /// Buffers for additional likelihoods, indexed by likelihood index minus one
+    std::vector<Float_t> bfPtTopLepVar, bfPtTopHadVar, bfMassTTVar;
 };
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Plugin.hpp>
+
+#include <Rtypes.h>
+
+
+class TTree;
+
+
+/**
+ * \class VarsReader
+ * 
+ * A plugin that reads ntuples produced by VarWriter or SmearMttWriter
+ * 
+ * Reads the Vars trees with per-event observables, providing them to downstream plugins such as
+ * TemplateBuilder. The parton-level mass of the tt system is optional, since it is only stored
+ * when requested at ntuple production.
+ */
+class VarsReader: public Plugin
+{
+public:
+    VarsReader();
+    
+public:
+    /// Sets up reading of the Vars tree
+    virtual void BeginFile(TFile *inputFile) override;
+    
+    /**
+     * Creates a clone of this plugin
+     * 
+     * Implemented from Plugin.
+     */
+    virtual Plugin *Clone() const override;
+    
+    /// Returns reconstructed (or smeared) mass of the tt system
+    double GetMassTT() const;
+    
+    /**
+     * Returns parton-level mass of the tt system
+     * 
+     * Only available when HasPartonMassTT reports true.
+     */
+    double GetPartonMassTT() const;
+    
+    /// Returns nominal per-event weight
+    double GetWeight() const;
+    
+    /// Reports whether the input tree contains the parton-level mass
+    bool HasPartonMassTT() const;
+    
+    /// Reads next event from the input file
+    virtual EventOutcome ProcessEventToOutcome() override;
+    
+private:
+    /// Non-owning pointer to the Vars tree
+    TTree *tree;
+    
+    /// Total number of events in the tree and index of the current event
+    unsigned long long numEvents, iEvent;
+    
+    // Buffers to read the tree
+    Float_t bfWeight, bfMassTT, bfPartonMassTT;
+    
+    /// Flag showing whether the tree contains the parton-level mass
+    bool hasPartonMassTT;
+};
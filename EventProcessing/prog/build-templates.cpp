@@ -0,0 +1,79 @@
+/**
+ * This program builds binned mtt templates from the ntuples produced by VarWriter or
+ * SmearMttWriter, for the nominal weight and for a grid of reweighting points, in a single
+ * (optionally multithreaded) pass. It replaces the per-point passes over the ntuples done by
+ * the Python analysis tooling; the per-point weight curves are read from a ROOT file with one
+ * histogram of weight versus parton-level mtt per point.
+ */
+
+#include <Processor.hpp>
+#include <TemplateBuilder.hpp>
+#include <VarsReader.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+int main(int argc, char **argv)
+{
+    namespace po = boost::program_options;
+    
+    // Parse arguments
+    po::options_description options("Allowed options");
+    options.add_options()
+      ("help,h", "Prints help message")
+      ("inputFiles", po::value<std::vector<std::string>>(), "Input files")
+      ("output,o", po::value<std::string>()->default_value("templates.root"),
+        "Name for the output file")
+      ("weights,w", po::value<std::string>(),
+        "ROOT file with weight curves of the reweighting points")
+      ("scale,s", po::value<double>()->default_value(1.),
+        "Scale factor applied to all templates")
+      ("jobs,j", po::value<unsigned>()->default_value(1),
+        "Number of input files processed concurrently");
+    
+    po::positional_options_description positionalOptions;
+    positionalOptions.add("inputFiles", -1);
+    
+    po::variables_map optionsMap;
+    
+    po::store(
+      po::command_line_parser(argc, argv).options(options).positional(positionalOptions).run(),
+      optionsMap);
+    po::notify(optionsMap);
+    
+    if (optionsMap.count("help") or not optionsMap.count("inputFiles"))
+    {
+        std::cerr << "Builds binned mtt templates from Vars ntuples.\n";
+        std::cerr << "Usage: build-templates inputFiles [options]\n";
+        std::cerr << options << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::vector<std::string> inputFiles(optionsMap["inputFiles"].as<std::vector<std::string>>());
+    
+    
+    Processor processor(inputFiles.begin(), inputFiles.end());
+    processor.SetNumWorkers(optionsMap["jobs"].as<unsigned>());
+    
+    VarsReader reader;
+    processor.RegisterPlugin(&reader);
+    
+    std::vector<double> binning{350, 368, 388, 408, 430, 452, 476, 501, 528, 556, 585, 616, 648, 682, 718, 756, 796, 838, 882, 928, 977, 1029, 1083, 1140, 1200};
+    
+    TemplateBuilder builder(&reader, binning, optionsMap["output"].as<std::string>());
+    builder.SetScaleFactor(optionsMap["scale"].as<double>());
+    
+    if (optionsMap.count("weights"))
+        builder.AddReweightedPointsFromFile(optionsMap["weights"].as<std::string>());
+    
+    processor.RegisterPlugin(&builder);
+    
+    processor.Run();
+    
+    
+    return EXIT_SUCCESS;
+}
@@ -27,6 +27,7 @@ int main(int argc, char **argv)
     processor.SetOutput("output");
     
     DelphesReaderGen reader;
+    reader.SetLHEPreFilter(&LJetsLHEFilter::PassPIDs, "ljets");
     processor.RegisterPlugin(&reader);
     
     LJetsLHEFilter lheFilter(&reader);
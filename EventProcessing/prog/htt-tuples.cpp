@@ -4,7 +4,11 @@
 #include <TTReco.hpp>
 #include <VarWriter.hpp>
 
+#include <boost/program_options.hpp>
+
 #include <iostream>
+#include <string>
+#include <vector>
 
 
 using std::cout;
@@ -12,15 +16,39 @@ using std::cout;
 
 int main(int argc, char **argv)
 {
-    if (argc < 2)
+    namespace po = boost::program_options;
+    
+    // Parse arguments
+    po::options_description options("Allowed options");
+    options.add_options()
+      ("help,h", "Prints help message")
+      ("inputFiles", po::value<std::vector<std::string>>(), "Input files")
+      ("jobs,j", po::value<unsigned>()->default_value(1),
+        "Number of input files processed concurrently");
+    
+    po::positional_options_description positionalOptions;
+    positionalOptions.add("inputFiles", -1);
+    
+    po::variables_map optionsMap;
+    
+    po::store(
+      po::command_line_parser(argc, argv).options(options).positional(positionalOptions).run(),
+      optionsMap);
+    po::notify(optionsMap);
+    
+    if (optionsMap.count("help") or not optionsMap.count("inputFiles"))
     {
-        std::cerr << "Usage: htt-tuples INPUT_FILE_MASK\n";
+        std::cerr << "Usage: htt-tuples inputFiles [options]\n";
+        std::cerr << options << std::endl;
         return EXIT_FAILURE;
     }
     
+    std::vector<std::string> inputFiles(optionsMap["inputFiles"].as<std::vector<std::string>>());
     
-    Processor processor(argv + 1, argv + argc);
+    
+    Processor processor(inputFiles.begin(), inputFiles.end());
     processor.SetOutput("output");
+    processor.SetNumWorkers(optionsMap["jobs"].as<unsigned>());
     
     DelphesReader reader;
     processor.RegisterPlugin(&reader);
@@ -36,6 +64,9 @@ int main(int argc, char **argv)
     
     processor.Run();
     
+    cout << '\n';
+    ttReco.PrintStats();
+    
     
     return EXIT_SUCCESS;
 }
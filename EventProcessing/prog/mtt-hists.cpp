@@ -23,7 +23,9 @@ int main(int argc, char **argv)
     options.add_options()
       ("help,h", "Prints help message")
       ("inputFiles", po::value<std::vector<std::string>>(), "Input files")
-      ("resolution,r", po::value<double>()->default_value(0.2), "Relative mtt resolution");
+      ("resolution,r", po::value<double>()->default_value(0.2), "Relative mtt resolution")
+      ("mergedOutput,m", po::value<std::string>(),
+        "Merge histograms over all input files into the given output file");
     
     po::positional_options_description positionalOptions;
     positionalOptions.add("inputFiles", -1);
@@ -54,10 +56,15 @@ int main(int argc, char **argv)
     
     
     Processor processor(inputFiles.begin(), inputFiles.end());
-    processor.SetOutput("output");
+    
+    if (optionsMap.count("mergedOutput"))
+        processor.SetMergedOutput(optionsMap["mergedOutput"].as<std::string>());
+    else
+        processor.SetOutput("output");
     
     DelphesReaderGen reader;
     reader.SetReadLHEWeights();
+    reader.SetLHEPreFilter(&LJetsLHEFilter::PassPIDs, "ljets");
     processor.RegisterPlugin(&reader);
     
     LJetsLHEFilter lheFilter(&reader);
@@ -39,6 +39,9 @@ int main(int argc, char **argv)
     
     processor.Run();
     
+    cout << '\n';
+    ttReco.PrintStats();
+    
     cout << '\n';
     perf.PrintCounts();
     
@@ -0,0 +1,42 @@
+/**
+ * This program writes selected events into compact skims, which can then be used instead of the
+ * original Delphes files (with plugin SkimReader) to iterate quickly on reconstruction studies.
+ */
+
+#include <DelphesReader.hpp>
+#include <LJetsSelection.hpp>
+#include <Processor.hpp>
+#include <SkimWriter.hpp>
+
+#include <iostream>
+
+
+using std::cout;
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: skim-events INPUT_FILE_MASK\n";
+        return EXIT_FAILURE;
+    }
+    
+    
+    Processor processor(argv + 1, argv + argc);
+    processor.SetOutput("skims");
+    
+    DelphesReader reader;
+    processor.RegisterPlugin(&reader);
+    
+    LJetsSelection selection(&reader);
+    processor.RegisterPlugin(&selection);
+    
+    SkimWriter writer(&reader);
+    processor.RegisterPlugin(&writer);
+    
+    processor.Run();
+    
+    
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+#include <AsyncTreeWriter.hpp>
+
+#include <TBranch.h>
+#include <TROOT.h>
+#include <TTree.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+
+AsyncTreeWriter::AsyncTreeWriter(TTree *tree_, bool asynchronous_, unsigned batchSize_):
+    tree(tree_), asynchronous(asynchronous_), batchSize(batchSize_),
+    fillingStarted(false), flushed(false),
+    pendingAvailable(false), terminate(false)
+{
+    if (asynchronous)
+        ROOT::EnableThreadSafety();
+}
+
+
+AsyncTreeWriter::~AsyncTreeWriter()
+{
+    Flush();
+}
+
+
+void AsyncTreeWriter::Branch(std::string const &name, Float_t *source)
+{
+    // A branch declared earlier is merely reconnected to the given buffer
+    for (unsigned i = 0; i < branchNames.size(); ++i)
+    {
+        if (branchNames[i] == name)
+        {
+            sources[i] = source;
+            return;
+        }
+    }
+    
+    if (fillingStarted)
+    {
+        std::ostringstream message;
+        message << "AsyncTreeWriter::Branch: Cannot declare branch \"" << name <<
+          "\" after the first call to Fill.";
+        throw std::runtime_error(message.str());
+    }
+    
+    branchNames.emplace_back(name);
+    sources.emplace_back(source);
+    writeBuffer.emplace_back(0.f);
+    
+    TBranch *branch = tree->Branch(name.c_str(), &writeBuffer.back(),
+      writeOptions.BasketSize(32000));
+    writeOptions.Apply(*branch);
+}
+
+
+void AsyncTreeWriter::Fill()
+{
+    if (not fillingStarted)
+    {
+        fillingStarted = true;
+        
+        if (asynchronous)
+            writerThread = std::thread(&AsyncTreeWriter::WriterLoop, this);
+    }
+    
+    
+    if (not asynchronous)
+    {
+        // Copy current buffer values and fill the tree immediately
+        for (unsigned i = 0; i < sources.size(); ++i)
+            writeBuffer[i] = *sources[i];
+        
+        tree->Fill();
+        return;
+    }
+    
+    
+    // Append current buffer values to the active batch and hand the batch over to the writer
+    //thread once it has grown large enough
+    for (auto const &source: sources)
+        activeBatch.emplace_back(*source);
+    
+    if (activeBatch.size() >= batchSize * sources.size())
+        EnqueueBatch();
+}
+
+
+TTree *AsyncTreeWriter::GetTree() const
+{
+    return tree;
+}
+
+
+void AsyncTreeWriter::SetWriteOptions(TreeWriteOptions const &options)
+{
+    writeOptions = options;
+    writeOptions.Apply(*tree);
+}
+
+
+void AsyncTreeWriter::Flush()
+{
+    if (flushed)
+        return;
+    
+    flushed = true;
+    
+    if (not asynchronous or not fillingStarted)
+    {
+        // In the synchronous mode all events have already been written. If filling has not
+        //started, there is no writer thread to stop.
+        return;
+    }
+    
+    
+    // Hand over the last, possibly incomplete, batch and ask the writer thread to terminate
+    if (not activeBatch.empty())
+        EnqueueBatch();
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        terminate = true;
+    }
+    
+    condNewWork.notify_one();
+    writerThread.join();
+}
+
+
+void AsyncTreeWriter::EnqueueBatch()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        
+        // Wait until the previous batch has been picked up by the writer thread
+        condWorkDone.wait(lock, [this]{return not pendingAvailable;});
+        
+        std::swap(activeBatch, pendingBatch);
+        pendingAvailable = true;
+    }
+    
+    condNewWork.notify_one();
+    activeBatch.clear();
+}
+
+
+void AsyncTreeWriter::WriterLoop()
+{
+    std::vector<Float_t> batch;
+    
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condNewWork.wait(lock, [this]{return pendingAvailable or terminate;});
+            
+            if (not pendingAvailable)
+            {
+                // Termination has been requested and no work is left
+                return;
+            }
+            
+            std::swap(batch, pendingBatch);
+            pendingAvailable = false;
+        }
+        
+        condWorkDone.notify_one();
+        
+        // The batch is processed outside of the critical section so that the producing thread
+        //can accumulate events in parallel
+        WriteBatch(batch);
+        batch.clear();
+    }
+}
+
+
+void AsyncTreeWriter::WriteBatch(std::vector<Float_t> const &batch)
+{
+    unsigned const numBranches = sources.size();
+    
+    for (unsigned offset = 0; offset < batch.size(); offset += numBranches)
+    {
+        for (unsigned i = 0; i < numBranches; ++i)
+            writeBuffer[i] = batch[offset + i];
+        
+        tree->Fill();
+    }
+}
@@ -0,0 +1,76 @@
+#include <CounterRNG.hpp>
+
+#include <cmath>
+
+
+CounterRNG::CounterRNG(unsigned long long seed_):
+    seed(seed_),
+    streamBase(0), counter(0),
+    cachedGaus(0.), hasCachedGaus(false)
+{}
+
+
+double CounterRNG::Gaus(double mean, double sigma)
+{
+    if (hasCachedGaus)
+    {
+        hasCachedGaus = false;
+        return mean + sigma * cachedGaus;
+    }
+    
+    
+    // Box-Muller transform. Uniform() never returns exactly zero, so the logarithm is safe.
+    double const u1 = Uniform();
+    double const u2 = Uniform();
+    
+    double const radius = std::sqrt(-2. * std::log(u1));
+    double const angle = 2. * M_PI * u2;
+    
+    cachedGaus = radius * std::sin(angle);
+    hasCachedGaus = true;
+    
+    return mean + sigma * radius * std::cos(angle);
+}
+
+
+unsigned long long CounterRNG::HashName(std::string const &name)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    
+    for (char const c: name)
+    {
+        hash ^= (unsigned char)c;
+        hash *= 1099511628211ULL;
+    }
+    
+    return hash;
+}
+
+
+void CounterRNG::SetStream(unsigned long long fileKey, unsigned long long event)
+{
+    streamBase = Mix(Mix(seed ^ Mix(fileKey)) ^ Mix(event));
+    counter = 0;
+    hasCachedGaus = false;
+}
+
+
+double CounterRNG::Uniform()
+{
+    ++counter;
+    unsigned long long const value = Mix(streamBase + counter);
+    
+    // Use the upper 53 bits and offset by half a step so that the result is strictly inside
+    //(0, 1)
+    return ((value >> 11) + 0.5) * (1. / 9007199254740992.);
+}
+
+
+unsigned long long CounterRNG::Mix(unsigned long long x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    
+    return x ^ (x >> 31);
+}
@@ -7,11 +7,14 @@
 #include <algorithm>
 #include <cmath>
 #include <stdexcept>
+#include <utility>
 
 
 DelphesReader::DelphesReader():
     DelphesReaderBase(),
-    bfElectrons(nullptr), bfMuons(nullptr), bfJets(nullptr), bfMETs(nullptr)
+    bfElectrons(nullptr), bfMuons(nullptr), bfJets(nullptr),
+    jetsDecoded(false),
+    bfMETs(nullptr), curMET(nullptr)
 {}
 
 
@@ -24,27 +27,84 @@ DelphesReader::~DelphesReader()
 }
 
 
+Plugin *DelphesReader::Clone() const
+{
+    DelphesReader *clone = new DelphesReader;
+    CopyConfiguration(*clone);
+    
+    return clone;
+}
+
+
 std::vector<Electron> const &DelphesReader::GetElectrons() const
 {
+    if (eventAdopted)
+        return servedElectrons;
+    
     return electrons;
 }
 
 
 std::vector<Muon> const &DelphesReader::GetMuons() const
 {
+    if (eventAdopted)
+        return servedMuons;
+    
     return muons;
 }
 
 
 std::vector<Jet> const &DelphesReader::GetJets() const
 {
+    if (eventAdopted)
+        return servedJets;
+    
+    if (not jetsDecoded)
+    {
+        ReadBranchEntry("Jet");
+        DecodeJets();
+    }
+    
     return jets;
 }
 
 
 MissingET const &DelphesReader::GetMissPt() const
 {
-    return *dynamic_cast<MissingET *>(bfMETs->At(0));
+    if (eventAdopted)
+        return adoptedMET;
+    
+    return *curMET;
+}
+
+
+void DelphesReader::ExtractEventData(EventData &data)
+{
+    ExtractCommonEventData(data);
+    
+    // Force the lazily decoded jets before the handover
+    if (not jetsDecoded)
+    {
+        ReadBranchEntry("Jet");
+        DecodeJets();
+    }
+    
+    std::swap(data.electrons, electrons);
+    std::swap(data.muons, muons);
+    std::swap(data.jets, jets);
+    data.met = *curMET;
+}
+
+
+void DelphesReader::AdoptEventData(EventData &data)
+{
+    AdoptCommonEventData(data);
+    
+    std::swap(servedElectrons, data.electrons);
+    std::swap(servedMuons, data.muons);
+    std::swap(servedJets, data.jets);
+    
+    adoptedMET = data.met;
 }
 
 
@@ -53,18 +113,43 @@ void DelphesReader::ReadEvent()
     // Read objects provided by the base class
     DelphesReaderBase::ReadEvent();
     
+    curMET = dynamic_cast<MissingET *>(bfMETs->At(0));
+    
     
     // Copy objects from collections into vectors to avoid dealing with TCloneArrays. In case of
-    //jets only save those that pass the kinematic selection.
-    electrons.clear();
-    muons.clear();
-    jets.clear();
+    //jets only save those that pass the kinematic selection. The vectors are refilled in place,
+    //reusing storage left over from the previous event.
+    unsigned numElectrons = 0, numMuons = 0;
     
     for (int i = 0; i < bfElectrons->GetEntries(); ++i)
-        electrons.emplace_back(*dynamic_cast<Electron *>(bfElectrons->At(i)));
+        AppendToPool(electrons, numElectrons, *dynamic_cast<Electron *>(bfElectrons->At(i)));
+    
+    TrimPool(electrons, numElectrons);
     
     for (int i = 0; i < bfMuons->GetEntries(); ++i)
-        muons.emplace_back(*dynamic_cast<Muon *>(bfMuons->At(i)));
+        AppendToPool(muons, numMuons, *dynamic_cast<Muon *>(bfMuons->At(i)));
+    
+    TrimPool(muons, numMuons);
+    
+    // Make sure lepton collections are ordered in pt
+    auto comp = [](auto const &c1, auto const &c2){return (c1.PT > c2.PT);};
+    
+    std::sort(electrons.begin(), electrons.end(), comp);
+    std::sort(muons.begin(), muons.end(), comp);
+    
+    
+    // Jets are only decoded now if the two-phase reading is not used; otherwise the decoding is
+    //deferred until the collection is accessed
+    if (twoPhaseReading)
+        jetsDecoded = false;
+    else
+        DecodeJets();
+}
+
+
+void DelphesReader::DecodeJets() const
+{
+    unsigned numJets = 0;
     
     for (int i = 0; i < bfJets->GetEntries(); ++i)
     {
@@ -80,16 +165,15 @@ void DelphesReader::ReadEvent()
         j->Constituents.Delete();
         j->Particles.Delete();
         
-        jets.emplace_back(std::move(*j));
+        AppendToPool(jets, numJets, *j);
     }
     
+    TrimPool(jets, numJets);
     
-    // Make sure collections are ordered in pt
-    auto comp = [](auto const &c1, auto const &c2){return (c1.PT > c2.PT);};
+    std::sort(jets.begin(), jets.end(),
+      [](auto const &c1, auto const &c2){return (c1.PT > c2.PT);});
     
-    std::sort(electrons.begin(), electrons.end(), comp);
-    std::sort(muons.begin(), muons.end(), comp);
-    std::sort(jets.begin(), jets.end(), comp);
+    jetsDecoded = true;
 }
 
 
@@ -106,4 +190,9 @@ void DelphesReader::SetupBuffers()
     tree->SetBranchAddress("Muon", &bfMuons);
     tree->SetBranchAddress("Jet", &bfJets);
     tree->SetBranchAddress("MissingET", &bfMETs);
+    
+    // In the two-phase mode the light collections needed by the early selection cuts are decoded
+    //upfront, while the jet branch is left for lazy decoding
+    for (auto const &name: {"Electron", "Muon", "MissingET"})
+        DeclareEagerBranch(name);
 }
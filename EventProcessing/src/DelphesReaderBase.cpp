@@ -1,16 +1,30 @@
 #include <DelphesReaderBase.hpp>
 
+#include <EntryListCache.hpp>
+
+#include <TBranch.h>
 #include <TClonesArray.h>
 #include <TFile.h>
 #include <TTree.h>
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
+#include <utility>
 
 
 DelphesReaderBase::DelphesReaderBase(double jetPtThreshold_, double jetEtaThreshold_):
     jetPtThreshold(jetPtThreshold_), jetEtaThreshold(jetEtaThreshold_),
+    twoPhaseReading(false),
+    entryRangeSet(false), entryRangeFirst(0), entryRangeCount(0),
+    treeCacheSize(0),
+    treeName("Delphes"),
     bfEvents(nullptr), bfLHEParticles(nullptr), bfLHEWeights(nullptr),
-    readLHEWeights(false)
+    readLHEWeights(false),
+    eventAdopted(false), adoptedWeight(0.), adoptedEntry(0),
+    lheParticlesDecoded(false), lheWeightsDecoded(false),
+    brLHEFilter(nullptr), usingCachedEntries(false), nextAcceptedEntry(0),
+    partonTTP4Cached(false), missPtP4Cached(false), jetP4sCached(false)
 {}
 
 
@@ -24,82 +38,447 @@ DelphesReaderBase::~DelphesReaderBase()
 
 void DelphesReaderBase::BeginFile(TFile *inputFile)
 {
-    // Set up reading of Delphes tree. It is important that all buffers are initialized with null
-    //pointers (which instructs TTree to allocate memory for them).
-    tree = dynamic_cast<TTree *>(inputFile->Get("Delphes"));
+    // Set up reading of the input tree. It is important that all buffers are initialized with
+    //null pointers (which instructs TTree to allocate memory for them).
+    tree = dynamic_cast<TTree *>(inputFile->Get(treeName.c_str()));
     
     numEvents = tree->GetEntries();
     iEvent = 0;
+    eventAdopted = false;
+    
+    // Any entry list of a previous file no longer applies
+    usingCachedEntries = false;
+    nextAcceptedEntry = 0;
+    
+    // Clamp to the requested entry range, if any
+    if (entryRangeSet)
+    {
+        iEvent = std::min(entryRangeFirst, numEvents);
+        
+        if (entryRangeCount < numEvents - iEvent)
+            numEvents = iEvent + entryRangeCount;
+    }
     
     tree->SetBranchStatus("*", false);
+    
+    eagerBranchNames.clear();
     SetupBuffers();
+    
+    
+    // Enable the read-ahead cache if requested
+    if (treeCacheSize > 0)
+    {
+        tree->SetCacheSize(treeCacheSize);
+        tree->AddBranchToCache("*", true);
+    }
+    
+    
+    // Resolve the eager branches of the new tree
+    if (twoPhaseReading)
+    {
+        eagerBranches.clear();
+        
+        for (auto const &name: eagerBranchNames)
+            eagerBranches.push_back(tree->GetBranch(name.c_str()));
+    }
+    
+    
+    // Set up the LHE-level filter for the new file, replaying a cached accepted-entry list when
+    //one is available. The cache describes whole files and is therefore bypassed when an entry
+    //range is active.
+    if (lhePreFilter)
+    {
+        brLHEFilter = tree->GetBranch("ParticleLHEF");
+        
+        usingCachedEntries = (not entryRangeSet) and EntryListCache::Load(
+          EntryListCache::BuildPath(inputFile->GetName(), lhePreFilterName), lhePreFilterName,
+          numEvents, acceptedEntries);
+        nextAcceptedEntry = 0;
+        newAcceptedEntries.clear();
+    }
+}
+
+
+void DelphesReaderBase::EndFile()
+{
+    // Persist the accepted-entry list built in this job so that subsequent jobs can replay it
+    if (lhePreFilter and not usingCachedEntries and not entryRangeSet)
+        EntryListCache::Save(
+          EntryListCache::BuildPath(tree->GetCurrentFile()->GetName(), lhePreFilterName),
+          lhePreFilterName, numEvents, newAcceptedEntries);
+}
+
+
+std::vector<TLorentzVector> const &DelphesReaderBase::GetJetP4s() const
+{
+    if (not jetP4sCached)
+    {
+        BuildJetP4s(jetP4s);
+        jetP4sCached = true;
+    }
+    
+    return jetP4s;
 }
 
 
 std::vector<GenParticle> const &DelphesReaderBase::GetLHEParticles() const
 {
+    if (eventAdopted)
+        return servedLHEParticles;
+    
+    if (not lheParticlesDecoded)
+    {
+        ReadBranchEntry("ParticleLHEF");
+        DecodeLHEParticles();
+    }
+    
     return lheParticles;
 }
 
 
+unsigned long long DelphesReaderBase::GetNumEvents() const
+{
+    return numEvents;
+}
+
+
+long long DelphesReaderBase::GetReadEntry() const
+{
+    if (eventAdopted)
+        return adoptedEntry;
+    
+    return curEntry;
+}
+
+
 std::vector<LHEFWeight> const &DelphesReaderBase::GetLHEWeights() const
 {
     if (not readLHEWeights)
         throw std::runtime_error("DelphesReaderBase::GetLHEWeights: Reading of LHE weights "
           "has not been requested");
     
+    if (eventAdopted)
+        return servedLHEWeights;
+    
+    if (not lheWeightsDecoded)
+    {
+        ReadBranchEntry("WeightLHEF");
+        DecodeLHEWeights();
+    }
+    
     return lheWeights;
 }
 
 
+TLorentzVector const &DelphesReaderBase::GetMissPtP4() const
+{
+    if (not missPtP4Cached)
+    {
+        missPtP4 = GetMissPt().P4();
+        missPtP4Cached = true;
+    }
+    
+    return missPtP4;
+}
+
+
+TLorentzVector const &DelphesReaderBase::GetPartonTTP4() const
+{
+    if (not partonTTP4Cached)
+    {
+        partonTTP4.SetXYZT(0., 0., 0., 0.);
+        
+        for (auto const &p: GetLHEParticles())
+        {
+            if (std::abs(p.PID) == 6)
+                partonTTP4 += p.P4();
+        }
+        
+        partonTTP4Cached = true;
+    }
+    
+    return partonTTP4;
+}
+
+
 double DelphesReaderBase::GetWeight() const
 {
+    if (eventAdopted)
+        return adoptedWeight;
+    
     return dynamic_cast<HepMCEvent *>(bfEvents->At(0))->Weight;
 }
 
 
+void DelphesReaderBase::ExtractEventData(EventData &)
+{
+    throw std::logic_error("DelphesReaderBase::ExtractEventData: This reader does not support "
+      "pipelined reading.");
+}
+
+
+void DelphesReaderBase::AdoptEventData(EventData &)
+{
+    throw std::logic_error("DelphesReaderBase::AdoptEventData: This reader does not support "
+      "pipelined reading.");
+}
+
+
+void DelphesReaderBase::ExtractCommonEventData(EventData &data)
+{
+    // Force lazily decoded collections before the handover. Public accessors are avoided here
+    //since, once events have been adopted, they serve buffers owned by the processing thread.
+    if (not lheParticlesDecoded)
+    {
+        ReadBranchEntry("ParticleLHEF");
+        DecodeLHEParticles();
+    }
+    
+    data.weight = dynamic_cast<HepMCEvent *>(bfEvents->At(0))->Weight;
+    data.entry = curEntry;
+    std::swap(data.lheParticles, lheParticles);
+    
+    if (readLHEWeights)
+    {
+        if (not lheWeightsDecoded)
+        {
+            ReadBranchEntry("WeightLHEF");
+            DecodeLHEWeights();
+        }
+        
+        std::swap(data.lheWeights, lheWeights);
+    }
+}
+
+
+void DelphesReaderBase::AdoptCommonEventData(EventData &data)
+{
+    std::swap(servedLHEParticles, data.lheParticles);
+    
+    if (readLHEWeights)
+        std::swap(servedLHEWeights, data.lheWeights);
+    
+    adoptedWeight = data.weight;
+    adoptedEntry = data.entry;
+    eventAdopted = true;
+    
+    // Derived quantities of the previously served event are no longer valid
+    partonTTP4Cached = missPtP4Cached = jetP4sCached = false;
+}
+
+
 Plugin::EventOutcome DelphesReaderBase::ProcessEventToOutcome()
 {
-    // Check if there are events remaining in the input tree
-    if (iEvent == numEvents)
-        return Plugin::EventOutcome::NoEvents;
+    if (usingCachedEntries)
+    {
+        // Replay a precomputed list of accepted entries
+        if (nextAcceptedEntry == acceptedEntries.size())
+            return Plugin::EventOutcome::NoEvents;
+        
+        curEntry = acceptedEntries[nextAcceptedEntry];
+        ++nextAcceptedEntry;
+        iEvent = curEntry + 1;
+    }
+    else if (lhePreFilter)
+    {
+        // Find the next entry passing the LHE-level filter; anything else is never decoded
+        if (not AdvanceToAcceptedEntry())
+            return Plugin::EventOutcome::NoEvents;
+    }
+    else
+    {
+        // Check if there are events remaining in the input tree
+        if (iEvent == numEvents)
+            return Plugin::EventOutcome::NoEvents;
+        
+        curEntry = iEvent;
+        ++iEvent;
+    }
     
     
-    // Read the next event
-    tree->GetEntry(iEvent);
-    ++iEvent;
+    // Read the current entry. In the two-phase mode only the eager branches are decoded here;
+    //the remaining ones are decoded on first access.
+    if (twoPhaseReading)
+    {
+        for (TBranch *b: eagerBranches)
+            b->GetEntry(curEntry);
+    }
+    else
+        tree->GetEntry(curEntry);
     
     ReadEvent();
     
+    // Cached derived quantities of the previous event are no longer valid
+    partonTTP4Cached = missPtP4Cached = jetP4sCached = false;
+    
     return Plugin::EventOutcome::Ok;
 }
 
 
+void DelphesReaderBase::SetCacheSize(long long bytes)
+{
+    treeCacheSize = bytes;
+}
+
+
+void DelphesReaderBase::SetEntryRange(unsigned long long firstEntry,
+  unsigned long long numEntries)
+{
+    entryRangeSet = true;
+    entryRangeFirst = firstEntry;
+    entryRangeCount = numEntries;
+}
+
+
+void DelphesReaderBase::UseEntryList(std::vector<long long> const &entries)
+{
+    acceptedEntries = entries;
+    usingCachedEntries = true;
+    nextAcceptedEntry = 0;
+}
+
+
+void DelphesReaderBase::SetLHEPreFilter(std::function<bool(std::vector<int> const &)> filter,
+  std::string const &name)
+{
+    lhePreFilter = filter;
+    lhePreFilterName = name;
+}
+
+
 void DelphesReaderBase::SetReadLHEWeights(bool on)
 {
     readLHEWeights = on;
 }
 
 
-void DelphesReaderBase::ReadEvent()
+void DelphesReaderBase::SetTwoPhaseReading(bool on)
+{
+    twoPhaseReading = on;
+}
+
+
+void DelphesReaderBase::BuildJetP4s(std::vector<TLorentzVector> &p4s) const
 {
-    lheParticles.clear();
+    auto const &jets = GetJets();
+    p4s.clear();
+    
+    for (auto const &j: jets)
+        p4s.emplace_back(j.P4());
+}
+
+
+void DelphesReaderBase::CopyConfiguration(DelphesReaderBase &clone) const
+{
+    clone.jetPtThreshold = jetPtThreshold;
+    clone.jetEtaThreshold = jetEtaThreshold;
+    clone.readLHEWeights = readLHEWeights;
+    clone.twoPhaseReading = twoPhaseReading;
+    clone.treeCacheSize = treeCacheSize;
+    clone.entryRangeSet = entryRangeSet;
+    clone.entryRangeFirst = entryRangeFirst;
+    clone.entryRangeCount = entryRangeCount;
+    clone.lhePreFilter = lhePreFilter;
+    clone.lhePreFilterName = lhePreFilterName;
+}
+
+
+void DelphesReaderBase::ReadLHEPidsForFilter(long long entry)
+{
+    // The master branch is read as a whole: reading only the PID leaf would leave the size of
+    //the container stale. The LHE record is small, so this is still far cheaper than decoding
+    //the event.
+    brLHEFilter->GetEntry(entry);
+    
+    pidScratch.clear();
     
     for (int i = 0; i < bfLHEParticles->GetEntries(); ++i)
-        lheParticles.emplace_back(*dynamic_cast<GenParticle *>(bfLHEParticles->At(i)));
+        pidScratch.push_back(dynamic_cast<GenParticle *>(bfLHEParticles->At(i))->PID);
+}
+
+
+void DelphesReaderBase::DeclareEagerBranch(std::string const &name)
+{
+    eagerBranchNames.push_back(name);
+}
+
+
+void DelphesReaderBase::ReadBranchEntry(std::string const &name) const
+{
+    tree->GetBranch(name.c_str())->GetEntry(curEntry);
+}
+
+
+void DelphesReaderBase::ReadEvent()
+{
+    if (twoPhaseReading)
+    {
+        // Decoding is deferred until the collections are accessed
+        lheParticlesDecoded = false;
+        lheWeightsDecoded = (not readLHEWeights);
+        return;
+    }
+    
+    DecodeLHEParticles();
     
     if (readLHEWeights)
+        DecodeLHEWeights();
+}
+
+
+bool DelphesReaderBase::AdvanceToAcceptedEntry()
+{
+    // Evaluate the filter on subsequent entries, reading only the LHE record
+    while (iEvent < numEvents)
     {
-        lheWeights.clear();
+        long long const entry = iEvent;
+        ++iEvent;
+        
+        ReadLHEPidsForFilter(entry);
+        
+        if (not lhePreFilter(pidScratch))
+            continue;
+        
+        newAcceptedEntries.push_back(entry);
+        curEntry = entry;
         
-        for (int i = 0; i < bfLHEWeights->GetEntries(); ++i)
-            lheWeights.emplace_back(*dynamic_cast<LHEFWeight *>(bfLHEWeights->At(i)));
+        return true;
     }
+    
+    return false;
+}
+
+
+void DelphesReaderBase::DecodeLHEParticles() const
+{
+    // The collection is refilled in place, reusing storage left over from the previous event
+    unsigned numParticles = 0;
+    
+    for (int i = 0; i < bfLHEParticles->GetEntries(); ++i)
+        AppendToPool(lheParticles, numParticles,
+          *dynamic_cast<GenParticle *>(bfLHEParticles->At(i)));
+    
+    TrimPool(lheParticles, numParticles);
+    lheParticlesDecoded = true;
+}
+
+
+void DelphesReaderBase::DecodeLHEWeights() const
+{
+    unsigned numWeights = 0;
+    
+    for (int i = 0; i < bfLHEWeights->GetEntries(); ++i)
+        AppendToPool(lheWeights, numWeights, *dynamic_cast<LHEFWeight *>(bfLHEWeights->At(i)));
+    
+    TrimPool(lheWeights, numWeights);
+    lheWeightsDecoded = true;
 }
 
 
 void DelphesReaderBase::SetupBuffers()
 {
+    DeclareEagerBranch("Event");
+    
     for (auto const &mask: {"Event.Weight", "ParticleLHEF.*"})
         tree->SetBranchStatus(mask, true);
     
@@ -3,28 +3,36 @@
 #include <TClonesArray.h>
 #include <TFile.h>
 #include <TTree.h>
-#include <TVector.h>
 
 #include <boost/container/small_vector.hpp>
 
 #include <algorithm>
 #include <cmath>
-#include <functional>
+#include <utility>
 
 
-template<typename T, typename C>
-bool CheckOverlap(T const &obj, C const &collection, double dR = 0.4)
+/// Coordinate list with inline storage, avoiding heap traffic for typical multiplicities
+using CoordinateVector = boost::container::small_vector<double, 8>;
+
+
+/**
+ * Checks whether the given direction lies within sqrt(maxDR2) of any of the listed ones
+ * 
+ * The candidate coordinates are passed as flat arrays with precomputed values, so the pair loop
+ * involves no object indirections and no pow or Phi_mpi_pi calls.
+ */
+static bool OverlapsAny(double eta, double phi, CoordinateVector const &etas,
+  CoordinateVector const &phis, double maxDR2)
 {
-    for (auto const &element: collection)
+    for (unsigned i = 0; i < etas.size(); ++i)
     {
-        // Make a reference_wrapper regardless of whether elements of the collection are bare types
-        //or instances of reference_wrapper so that the two cases can be treated uniformly
-        auto const elementRef = std::cref(element);
+        double const dEta = eta - etas[i];
+        double dPhi = std::abs(phi - phis[i]);
         
-        double const dR2 = std::pow(obj.Eta - elementRef.get().Eta, 2) +
-          std::pow(TVector2::Phi_mpi_pi(obj.Phi - elementRef.get().Phi), 2);
+        if (dPhi > M_PI)
+            dPhi = 2 * M_PI - dPhi;
         
-        if (dR2 < dR * dR)
+        if (dEta * dEta + dPhi * dPhi < maxDR2)
             return true;
     }
     
@@ -45,41 +53,97 @@ DelphesReaderGen::~DelphesReaderGen()
 }
 
 
+Plugin *DelphesReaderGen::Clone() const
+{
+    DelphesReaderGen *clone = new DelphesReaderGen;
+    CopyConfiguration(*clone);
+    
+    return clone;
+}
+
+
 std::vector<Electron> const &DelphesReaderGen::GetElectrons() const
 {
+    if (eventAdopted)
+        return servedElectrons;
+    
     return electrons;
 }
 
 
 std::vector<Muon> const &DelphesReaderGen::GetMuons() const
 {
+    if (eventAdopted)
+        return servedMuons;
+    
     return muons;
 }
 
 
 std::vector<Jet> const &DelphesReaderGen::GetJets() const
 {
+    if (eventAdopted)
+        return servedJets;
+    
     return jets;
 }
 
 
 MissingET const &DelphesReaderGen::GetMissPt() const
 {
+    if (eventAdopted)
+        return adoptedMET;
+    
     return *dynamic_cast<MissingET *>(bfMETs->At(0));
 }
 
 
+void DelphesReaderGen::ExtractEventData(EventData &data)
+{
+    ExtractCommonEventData(data);
+    
+    std::swap(data.electrons, electrons);
+    std::swap(data.muons, muons);
+    std::swap(data.jets, jets);
+    data.met = *dynamic_cast<MissingET *>(bfMETs->At(0));
+}
+
+
+void DelphesReaderGen::AdoptEventData(EventData &data)
+{
+    AdoptCommonEventData(data);
+    
+    std::swap(servedElectrons, data.electrons);
+    std::swap(servedMuons, data.muons);
+    std::swap(servedJets, data.jets);
+    
+    adoptedMET = data.met;
+}
+
+
 void DelphesReaderGen::ReadEvent()
 {
     // Read objects provided by the base class
     DelphesReaderBase::ReadEvent();
     
     
+    // Make sure the LHE particles are decoded also in the two-phase reading mode. The decode
+    //buffer is used directly since this code runs on the reading thread.
+    if (not lheParticlesDecoded)
+    {
+        ReadBranchEntry("ParticleLHEF");
+        DecodeLHEParticles();
+    }
+    
+    auto const &particles = lheParticles;
+    
+    
     // Fill collections of leptons with muons and electrons from LHE. Only some fields are set.
+    
     electrons.clear();
     muons.clear();
     
-    for (auto const &p: lheParticles)
+    for (auto const &p: particles)
     {
         if (std::abs(p.PID) == 11)
         {
@@ -112,8 +176,24 @@ void DelphesReaderGen::ReadEvent()
     }
     
     
-    // Copy jets from the read buffer. Only keep those that pass the kinematic selection and do not
-    //overlap with the leptons.
+    // Copy jets from the read buffer. Only keep those that pass the kinematic selection and do
+    //not overlap with the leptons. The lepton coordinates are collected upfront into flat
+    //arrays with inline storage, so the pair loop is cheap.
+    double const maxOverlapDR2 = 0.4 * 0.4;
+    CoordinateVector lepEtas, lepPhis;
+    
+    for (auto const &e: electrons)
+    {
+        lepEtas.push_back(e.Eta);
+        lepPhis.push_back(e.Phi);
+    }
+    
+    for (auto const &mu: muons)
+    {
+        lepEtas.push_back(mu.Eta);
+        lepPhis.push_back(mu.Phi);
+    }
+    
     jets.clear();
     
     for (int i = 0; i < bfJets->GetEntries(); ++i)
@@ -123,7 +203,7 @@ void DelphesReaderGen::ReadEvent()
         if (j->PT < jetPtThreshold or std::abs(j->Eta) > jetEtaThreshold)
             continue;
         
-        if (CheckOverlap(*j, electrons) or CheckOverlap(*j, muons))
+        if (OverlapsAny(j->Eta, j->Phi, lepEtas, lepPhis, maxOverlapDR2))
             continue;
         
         // There is a memory leak in TRefArray [1], and class Jet contains members of this type.
@@ -138,17 +218,20 @@ void DelphesReaderGen::ReadEvent()
     
     
     // Emulate b-tagging by matching jets to b quarks
-    boost::container::small_vector<std::reference_wrapper<GenParticle const>, 2> bQuarks;
+    CoordinateVector bEtas, bPhis;
     
-    for (auto const &p: lheParticles)
+    for (auto const &p: particles)
     {
         if (std::abs(p.PID) == 5)
-            bQuarks.emplace_back(p);
+        {
+            bEtas.push_back(p.Eta);
+            bPhis.push_back(p.Phi);
+        }
     }
     
     for (auto &j: jets)
     {
-        if (CheckOverlap(j, bQuarks))
+        if (OverlapsAny(j.Eta, j.Phi, bEtas, bPhis, maxOverlapDR2))
             j.BTag = 1;
     }
     
@@ -173,4 +256,9 @@ void DelphesReaderGen::SetupBuffers()
     
     tree->SetBranchAddress("GenJet", &bfJets);
     tree->SetBranchAddress("GenMissingET", &bfMETs);
+    
+    // The generator-level collections are decoded in ReadEvent, so in the two-phase mode the
+    //corresponding branches must be read upfront
+    for (auto const &name: {"GenJet", "GenMissingET"})
+        DeclareEagerBranch(name);
 }
@@ -0,0 +1,421 @@
+#include <DelphesReaderSoA.hpp>
+
+#include <TBranch.h>
+#include <TLeaf.h>
+#include <TTree.h>
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+
+int const DelphesReaderSoA::LeptonArrays::maxSize;
+int const DelphesReaderSoA::JetArrays::maxSize;
+int const DelphesReaderSoA::maxLHEParticles;
+int const DelphesReaderSoA::maxLHEWeights;
+
+
+DelphesReaderSoA::DelphesReaderSoA():
+    DelphesReaderBase(),
+    electronObjectsBuilt(false), muonObjectsBuilt(false), jetObjectsBuilt(false)
+{}
+
+
+Plugin *DelphesReaderSoA::Clone() const
+{
+    DelphesReaderSoA *clone = new DelphesReaderSoA;
+    CopyConfiguration(*clone);
+    
+    return clone;
+}
+
+
+DelphesReaderSoA::LeptonArrays const &DelphesReaderSoA::GetElectronArrays() const
+{
+    return electrons;
+}
+
+
+std::vector<Electron> const &DelphesReaderSoA::GetElectrons() const
+{
+    if (not electronObjectsBuilt)
+    {
+        electronObjects.clear();
+        
+        for (int i = 0; i < electrons.size; ++i)
+        {
+            Electron e;
+            
+            e.PT = electrons.pt[i];
+            e.Eta = electrons.eta[i];
+            e.Phi = electrons.phi[i];
+            e.Charge = electrons.charge[i];
+            
+            e.T = e.EhadOverEem = e.IsolationVar = e.IsolationVarRhoCorr = e.SumPtCharged = \
+              e.SumPtNeutral = e.SumPtChargedPU = e.SumPt = 0.;
+            
+            electronObjects.emplace_back(std::move(e));
+        }
+        
+        electronObjectsBuilt = true;
+    }
+    
+    return electronObjects;
+}
+
+
+DelphesReaderSoA::JetArrays const &DelphesReaderSoA::GetJetArrays() const
+{
+    return jets;
+}
+
+
+std::vector<Jet> const &DelphesReaderSoA::GetJets() const
+{
+    if (not jetObjectsBuilt)
+    {
+        jetObjects.clear();
+        
+        for (int i = 0; i < jets.size; ++i)
+        {
+            Jet j;
+            
+            j.PT = jets.pt[i];
+            j.Eta = jets.eta[i];
+            j.Phi = jets.phi[i];
+            j.Mass = jets.mass[i];
+            j.BTag = jets.btag[i];
+            
+            j.T = j.DeltaEta = j.DeltaPhi = j.EhadOverEem = 0.;
+            j.TauTag = 0;
+            j.Charge = 0;
+            
+            jetObjects.emplace_back(std::move(j));
+        }
+        
+        jetObjectsBuilt = true;
+    }
+    
+    return jetObjects;
+}
+
+
+DelphesReaderSoA::LeptonArrays const &DelphesReaderSoA::GetMuonArrays() const
+{
+    return muons;
+}
+
+
+std::vector<Muon> const &DelphesReaderSoA::GetMuons() const
+{
+    if (not muonObjectsBuilt)
+    {
+        muonObjects.clear();
+        
+        for (int i = 0; i < muons.size; ++i)
+        {
+            Muon mu;
+            
+            mu.PT = muons.pt[i];
+            mu.Eta = muons.eta[i];
+            mu.Phi = muons.phi[i];
+            mu.Charge = muons.charge[i];
+            
+            mu.T = mu.IsolationVar = mu.IsolationVarRhoCorr = mu.SumPtCharged = \
+              mu.SumPtNeutral = mu.SumPtChargedPU = mu.SumPt = 0.;
+            
+            muonObjects.emplace_back(std::move(mu));
+        }
+        
+        muonObjectsBuilt = true;
+    }
+    
+    return muonObjects;
+}
+
+
+MissingET const &DelphesReaderSoA::GetMissPt() const
+{
+    return met;
+}
+
+
+double DelphesReaderSoA::GetWeight() const
+{
+    return eventWeight[0];
+}
+
+
+void DelphesReaderSoA::BuildJetP4s(std::vector<TLorentzVector> &p4s) const
+{
+    p4s.clear();
+    
+    for (int i = 0; i < jets.size; ++i)
+    {
+        TLorentzVector p4;
+        p4.SetPtEtaPhiM(jets.pt[i], jets.eta[i], jets.phi[i], jets.mass[i]);
+        p4s.push_back(p4);
+    }
+}
+
+
+void DelphesReaderSoA::ReadEvent()
+{
+    // Rebuild the LHE record from the flat arrays. The four-momentum components are recomputed
+    //from the stored kinematics so that GenParticle::P4 works as expected. The collections are
+    //filled here rather than by the standard decoding of the base class.
+    unsigned numParticles = 0;
+    
+    for (int i = 0; i < numLHEParticles; ++i)
+    {
+        GenParticle p;
+        
+        p.PID = lhePid[i];
+        p.M1 = lheMother[i];
+        p.M2 = p.D1 = p.D2 = -1;
+        p.Status = 0;
+        p.Charge = 0;
+        p.IsPU = 0;
+        
+        p.PT = lhePt[i];
+        p.Eta = lheEta[i];
+        p.Phi = lhePhi[i];
+        p.Mass = lheMass[i];
+        
+        TLorentzVector p4;
+        p4.SetPtEtaPhiM(p.PT, p.Eta, p.Phi, p.Mass);
+        p.Px = p4.Px();
+        p.Py = p4.Py();
+        p.Pz = p4.Pz();
+        p.E = p4.E();
+        
+        p.Rapidity = p4.Rapidity();
+        p.T = p.X = p.Y = p.Z = 0.;
+        
+        AppendToPool(lheParticles, numParticles, p);
+    }
+    
+    TrimPool(lheParticles, numParticles);
+    
+    if (readLHEWeights)
+    {
+        unsigned numWeights = 0;
+        
+        for (int i = 0; i < numLHEWeightRecords; ++i)
+        {
+            LHEFWeight weight;
+            weight.ID = lheWeightId[i];
+            weight.Weight = lheWeightValue[i];
+            
+            AppendToPool(lheWeights, numWeights, weight);
+        }
+        
+        TrimPool(lheWeights, numWeights);
+    }
+    
+    lheParticlesDecoded = lheWeightsDecoded = true;
+    
+    
+    // Apply the kinematic selection to jets, compacting the arrays in place
+    int numSelected = 0;
+    
+    for (int i = 0; i < jets.size; ++i)
+    {
+        if (jets.pt[i] < jetPtThreshold or std::abs(jets.eta[i]) > jetEtaThreshold)
+            continue;
+        
+        jets.pt[numSelected] = jets.pt[i];
+        jets.eta[numSelected] = jets.eta[i];
+        jets.phi[numSelected] = jets.phi[i];
+        jets.mass[numSelected] = jets.mass[i];
+        jets.btag[numSelected] = jets.btag[i];
+        ++numSelected;
+    }
+    
+    jets.size = numSelected;
+    
+    
+    // Make sure collections are ordered in pt
+    SortByPt(electrons);
+    SortByPt(muons);
+    SortByPt(jets);
+    
+    
+    // Translate missing pt into the representation expected by the standard interface. Only the
+    //transverse components are ever used downstream, so pseudorapidity is not read.
+    met.MET = metMet[0];
+    met.Phi = metPhi[0];
+    met.Eta = 0.;
+    
+    
+    // Collections of Delphes objects, if ever requested, will have to be rebuilt
+    electronObjectsBuilt = muonObjectsBuilt = jetObjectsBuilt = false;
+}
+
+
+void DelphesReaderSoA::ReadLHEPidsForFilter(long long entry)
+{
+    // Read the LHE master branch, which also updates the particle count, and collect the PDG
+    //IDs from the flat arrays
+    tree->GetBranch("ParticleLHEF")->GetEntry(entry);
+    
+    pidScratch.clear();
+    
+    for (int i = 0; i < numLHEParticles; ++i)
+        pidScratch.push_back(lhePid[i]);
+}
+
+
+void DelphesReaderSoA::SetupBuffers()
+{
+    // Switch the tree into the decomposed-object (MakeClass) mode, in which member leaves of
+    //the split TClonesArray branches are decoded into caller-provided flat arrays. The mode is
+    //tree-wide, which is why this reader does not share any reading with the base class.
+    tree->SetMakeClass(1);
+    
+    
+    // Per the MakeClass convention, the address of a master branch receives the number of
+    //objects, while the member leaves are connected through the sub-branch names
+    tree->SetBranchStatus("Event.Weight", true);
+    tree->SetBranchAddress("Event", &numEventRecords);
+    tree->SetBranchAddress("Event.Weight", eventWeight);
+    DeclareEagerBranch("Event");
+    
+    for (auto const &leaf: {"ParticleLHEF.PID", "ParticleLHEF.M1", "ParticleLHEF.PT",
+      "ParticleLHEF.Eta", "ParticleLHEF.Phi", "ParticleLHEF.Mass"})
+        tree->SetBranchStatus(leaf, true);
+    
+    tree->SetBranchAddress("ParticleLHEF", &numLHEParticles);
+    tree->SetBranchAddress("ParticleLHEF.PID", lhePid);
+    tree->SetBranchAddress("ParticleLHEF.M1", lheMother);
+    tree->SetBranchAddress("ParticleLHEF.PT", lhePt);
+    tree->SetBranchAddress("ParticleLHEF.Eta", lheEta);
+    tree->SetBranchAddress("ParticleLHEF.Phi", lhePhi);
+    tree->SetBranchAddress("ParticleLHEF.Mass", lheMass);
+    DeclareEagerBranch("ParticleLHEF");
+    
+    if (readLHEWeights)
+    {
+        for (auto const &leaf: {"WeightLHEF.ID", "WeightLHEF.Weight"})
+            tree->SetBranchStatus(leaf, true);
+        
+        tree->SetBranchAddress("WeightLHEF", &numLHEWeightRecords);
+        tree->SetBranchAddress("WeightLHEF.ID", lheWeightId);
+        tree->SetBranchAddress("WeightLHEF.Weight", lheWeightValue);
+        DeclareEagerBranch("WeightLHEF");
+    }
+    else
+        numLHEWeightRecords = 0;
+    
+    ConnectLeptonBranch("Electron", electrons);
+    ConnectLeptonBranch("Muon", muons);
+    
+    for (auto const &leaf: {"Jet.PT", "Jet.Eta", "Jet.Phi", "Jet.Mass", "Jet.BTag"})
+        tree->SetBranchStatus(leaf, true);
+    
+    tree->SetBranchAddress("Jet", &jets.size);
+    tree->SetBranchAddress("Jet.PT", jets.pt);
+    tree->SetBranchAddress("Jet.Eta", jets.eta);
+    tree->SetBranchAddress("Jet.Phi", jets.phi);
+    tree->SetBranchAddress("Jet.Mass", jets.mass);
+    tree->SetBranchAddress("Jet.BTag", jets.btag);
+    DeclareEagerBranch("Jet");
+    
+    for (auto const &leaf: {"MissingET.MET", "MissingET.Phi"})
+        tree->SetBranchStatus(leaf, true);
+    
+    tree->SetBranchAddress("MissingET", &numMET);
+    tree->SetBranchAddress("MissingET.MET", metMet);
+    tree->SetBranchAddress("MissingET.Phi", metPhi);
+    DeclareEagerBranch("MissingET");
+    
+    
+    // Make sure the buffers can accommodate every event of this tree. The check must precede
+    //any reading (including the probes of the LHE-level filter) since the decomposed-mode
+    //decoding would write past the end of a too-small array.
+    ValidateCapacity("Event", 1);
+    ValidateCapacity("ParticleLHEF", maxLHEParticles);
+    
+    if (readLHEWeights)
+        ValidateCapacity("WeightLHEF", maxLHEWeights);
+    
+    ValidateCapacity("Electron", LeptonArrays::maxSize);
+    ValidateCapacity("Muon", LeptonArrays::maxSize);
+    ValidateCapacity("Jet", JetArrays::maxSize);
+    ValidateCapacity("MissingET", 1);
+}
+
+
+void DelphesReaderSoA::ConnectLeptonBranch(std::string const &branchName, LeptonArrays &arrays)
+{
+    for (auto const &leaf: {".PT", ".Eta", ".Phi", ".Charge"})
+        tree->SetBranchStatus((branchName + leaf).c_str(), true);
+    
+    tree->SetBranchAddress(branchName.c_str(), &arrays.size);
+    tree->SetBranchAddress((branchName + ".PT").c_str(), arrays.pt);
+    tree->SetBranchAddress((branchName + ".Eta").c_str(), arrays.eta);
+    tree->SetBranchAddress((branchName + ".Phi").c_str(), arrays.phi);
+    tree->SetBranchAddress((branchName + ".Charge").c_str(), arrays.charge);
+    DeclareEagerBranch(branchName);
+}
+
+
+void DelphesReaderSoA::ValidateCapacity(std::string const &branchName, long long capacity) const
+{
+    // The maximal multiplicity is stored in the count leaf of the split branch (named with a
+    //trailing underscore); older layouts are covered by the explicit size branch
+    TLeaf *countLeaf = tree->FindLeaf((branchName + "_").c_str());
+    
+    if (not countLeaf)
+        countLeaf = tree->FindLeaf((branchName + "_size").c_str());
+    
+    if (not countLeaf)
+    {
+        std::ostringstream message;
+        message << "DelphesReaderSoA::ValidateCapacity: Cannot determine the maximal "
+          "multiplicity of branch \"" << branchName << "\".";
+        throw std::runtime_error(message.str());
+    }
+    
+    long long const maximum = countLeaf->GetMaximum();
+    
+    if (maximum > capacity)
+    {
+        std::ostringstream message;
+        message << "DelphesReaderSoA::ValidateCapacity: Branch \"" << branchName <<
+          "\" contains up to " << maximum << " objects per event, which exceeds the buffer "
+          "capacity of " << capacity << ".";
+        throw std::runtime_error(message.str());
+    }
+}
+
+
+template<typename Arrays>
+void DelphesReaderSoA::SortByPt(Arrays &arrays)
+{
+    // Collections in Delphes files are normally already ordered, so an insertion sort, which is
+    //linear for sorted inputs, is used
+    for (int i = 1; i < arrays.size; ++i)
+        for (int j = i; j > 0 and arrays.pt[j] > arrays.pt[j - 1]; --j)
+            arrays.SwapObjects(j, j - 1);
+}
+
+
+void DelphesReaderSoA::LeptonArrays::SwapObjects(int i, int j)
+{
+    std::swap(pt[i], pt[j]);
+    std::swap(eta[i], eta[j]);
+    std::swap(phi[i], phi[j]);
+    std::swap(charge[i], charge[j]);
+}
+
+
+void DelphesReaderSoA::JetArrays::SwapObjects(int i, int j)
+{
+    std::swap(pt[i], pt[j]);
+    std::swap(eta[i], eta[j]);
+    std::swap(phi[i], phi[j]);
+    std::swap(mass[i], mass[j]);
+    std::swap(btag[i], btag[j]);
+}
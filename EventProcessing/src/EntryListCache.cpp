@@ -0,0 +1,62 @@
+#include <EntryListCache.hpp>
+
+#include <fstream>
+
+
+std::string EntryListCache::BuildPath(std::string const &inputFile, std::string const &tag)
+{
+    return inputFile + ".entries-" + tag;
+}
+
+
+bool EntryListCache::Load(std::string const &path, std::string const &tag,
+  unsigned long long numEntries, std::vector<long long> &entries)
+{
+    std::ifstream input(path);
+    
+    if (not input)
+        return false;
+    
+    
+    // Validate the header
+    std::string cachedTag;
+    unsigned long long cachedNumEntries = 0;
+    unsigned long long numAccepted = 0;
+    
+    input >> cachedTag >> cachedNumEntries >> numAccepted;
+    
+    if (not input or cachedTag != tag or cachedNumEntries != numEntries)
+        return false;
+    
+    
+    entries.clear();
+    entries.reserve(numAccepted);
+    
+    for (unsigned long long i = 0; i < numAccepted; ++i)
+    {
+        long long entry;
+        input >> entry;
+        
+        if (not input)
+            return false;
+        
+        entries.push_back(entry);
+    }
+    
+    return true;
+}
+
+
+void EntryListCache::Save(std::string const &path, std::string const &tag,
+  unsigned long long numEntries, std::vector<long long> const &entries)
+{
+    std::ofstream output(path);
+    
+    if (not output)
+        return;
+    
+    output << tag << ' ' << numEntries << ' ' << entries.size() << '\n';
+    
+    for (long long const entry: entries)
+        output << entry << '\n';
+}
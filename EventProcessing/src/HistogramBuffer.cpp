@@ -0,0 +1,75 @@
+#include <HistogramBuffer.hpp>
+
+#include <algorithm>
+
+
+HistogramBuffer::HistogramBuffer(std::string const &inFileDirectory_, std::string const &name_,
+  std::string const &title_, std::vector<double> const &binning_):
+    inFileDirectory(inFileDirectory_), name(name_), title(title_),
+    binning(binning_),
+    numFills(0)
+{
+    sums.assign(binning.size() + 1, 0.);
+    sums2.assign(binning.size() + 1, 0.);
+}
+
+
+std::vector<double> const &HistogramBuffer::Binning() const
+{
+    return binning;
+}
+
+
+std::string const &HistogramBuffer::Directory() const
+{
+    return inFileDirectory;
+}
+
+
+void HistogramBuffer::Fill(double x, double weight)
+{
+    // The indexing matches ROOT conventions, with bin 0 being the underflow
+    unsigned const bin = std::upper_bound(binning.begin(), binning.end(), x) - binning.begin();
+    
+    sums[bin] += weight;
+    sums2[bin] += weight * weight;
+    ++numFills;
+}
+
+
+std::string const &HistogramBuffer::Name() const
+{
+    return name;
+}
+
+
+unsigned long long HistogramBuffer::NumFills() const
+{
+    return numFills;
+}
+
+
+void HistogramBuffer::Reset()
+{
+    std::fill(sums.begin(), sums.end(), 0.);
+    std::fill(sums2.begin(), sums2.end(), 0.);
+    numFills = 0;
+}
+
+
+std::vector<double> const &HistogramBuffer::Sums() const
+{
+    return sums;
+}
+
+
+std::vector<double> const &HistogramBuffer::SumsSquared() const
+{
+    return sums2;
+}
+
+
+std::string const &HistogramBuffer::Title() const
+{
+    return title;
+}
@@ -0,0 +1,115 @@
+#include <JetMatcher.hpp>
+
+#include <cmath>
+#include <stdexcept>
+
+
+JetMatcher::JetMatcher():
+    jets(nullptr)
+{}
+
+
+Jet const *JetMatcher::Match(GenParticle const &particle, double maxDR) const
+{
+    int match = -1;
+    double minDR2 = maxDR * maxDR;
+    
+    for (unsigned i = 0; i < etas.size(); ++i)
+    {
+        double const dEta = particle.Eta - etas[i];
+        double dPhi = std::abs(particle.Phi - phis[i]);
+        
+        if (dPhi > M_PI)
+            dPhi = 2 * M_PI - dPhi;
+        
+        double const dR2 = dEta * dEta + dPhi * dPhi;
+        
+        if (dR2 < minDR2)
+        {
+            match = i;
+            minDR2 = dR2;
+        }
+    }
+    
+    if (match < 0)
+        return nullptr;
+    
+    return &(*jets)[match];
+}
+
+
+bool JetMatcher::MatchDistinct(std::vector<GenParticle const *> const &particles, double maxDR,
+  std::vector<Jet const *> &matches) const
+{
+    unsigned const numParticles = particles.size();
+    
+    // Running best matches for all particles, updated in a single scan over the jets
+    static unsigned const maxParticles = 8;
+    
+    if (numParticles > maxParticles)
+        throw std::runtime_error("JetMatcher::MatchDistinct: Too many query particles.");
+    
+    int bestJet[maxParticles];
+    double minDR2[maxParticles];
+    
+    for (unsigned q = 0; q < numParticles; ++q)
+    {
+        bestJet[q] = -1;
+        minDR2[q] = maxDR * maxDR;
+    }
+    
+    for (unsigned i = 0; i < etas.size(); ++i)
+    {
+        for (unsigned q = 0; q < numParticles; ++q)
+        {
+            double const dEta = particles[q]->Eta - etas[i];
+            double dPhi = std::abs(particles[q]->Phi - phis[i]);
+            
+            if (dPhi > M_PI)
+                dPhi = 2 * M_PI - dPhi;
+            
+            double const dR2 = dEta * dEta + dPhi * dPhi;
+            
+            if (dR2 < minDR2[q])
+            {
+                bestJet[q] = i;
+                minDR2[q] = dR2;
+            }
+        }
+    }
+    
+    
+    // All particles must be matched, to mutually distinct jets
+    matches.assign(numParticles, nullptr);
+    
+    for (unsigned q = 0; q < numParticles; ++q)
+    {
+        if (bestJet[q] < 0)
+            return false;
+        
+        for (unsigned p = 0; p < q; ++p)
+        {
+            if (bestJet[p] == bestJet[q])
+                return false;
+        }
+        
+        matches[q] = &(*jets)[bestJet[q]];
+    }
+    
+    return true;
+}
+
+
+void JetMatcher::SetJets(std::vector<Jet> const &jets_)
+{
+    jets = &jets_;
+    
+    etas.clear();
+    phis.clear();
+    
+    for (auto const &j: jets_)
+    {
+        etas.push_back(j.Eta);
+        phis.push_back(j.Phi);
+    }
+}
@@ -10,13 +10,13 @@ LJetsLHEFilter::LJetsLHEFilter(DelphesReaderBase const *reader_):
 {}
 
 
-bool LJetsLHEFilter::ProcessEvent()
+bool LJetsLHEFilter::PassPIDs(std::vector<int> const &pids)
 {
     unsigned nE = 0, nMu = 0, nTau = 0;
     
-    for (auto const &p: reader->GetLHEParticles())
+    for (int const pid: pids)
     {
-        int const absPdgID = std::abs(p.PID);
+        int const absPdgID = std::abs(pid);
         
         if (absPdgID == 11)
             ++nE;
@@ -26,6 +26,30 @@ bool LJetsLHEFilter::ProcessEvent()
             ++nTau;
     }
     
-    
     return ((nE + nMu) == 1 and nTau == 0);
 }
+
+
+Plugin *LJetsLHEFilter::Clone() const
+{
+    return new LJetsLHEFilter(*this);
+}
+
+
+void LJetsLHEFilter::RebindPlugin(Plugin const *from, Plugin const *to)
+{
+    if (reader == from)
+        reader = dynamic_cast<DelphesReaderBase const *>(to);
+}
+
+
+bool LJetsLHEFilter::ProcessEvent()
+{
+    pids.clear();
+    
+    for (auto const &p: reader->GetLHEParticles())
+        pids.push_back(p.PID);
+    
+    
+    return PassPIDs(pids);
+}
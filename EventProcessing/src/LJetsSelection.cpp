@@ -1,16 +1,25 @@
 #include <LJetsSelection.hpp>
 
+#include <DelphesReaderSoA.hpp>
+
 #include <cmath>
 
 
 LJetsSelection::LJetsSelection(DelphesReaderBase const *reader_):
     reader(reader_),
+    soaReader(dynamic_cast<DelphesReaderSoA const *>(reader_)),
     ptEleTight(30.), ptEleLoose(10.),
     ptMuTight(30.), ptMuLoose(10.),
     mtWThreshold(0.)
 {}
 
 
+Plugin *LJetsSelection::Clone() const
+{
+    return new LJetsSelection(*this);
+}
+
+
 TLorentzVector const &LJetsSelection::GetLeptonP4() const
 {
     return p4TightLepton;
@@ -23,8 +32,24 @@ double LJetsSelection::GetMtW() const
 }
 
 
+void LJetsSelection::RebindPlugin(Plugin const *from, Plugin const *to)
+{
+    if (reader == from)
+    {
+        reader = dynamic_cast<DelphesReaderBase const *>(to);
+        soaReader = dynamic_cast<DelphesReaderSoA const *>(to);
+    }
+}
+
+
 bool LJetsSelection::ProcessEvent()
 {
+    // With a structure-of-arrays reader the cuts are evaluated on its flat arrays, so that no
+    //Delphes objects are materialized for rejected events
+    if (soaReader)
+        return ProcessEventSoA();
+    
+    
     // Count tight and loose leptons and save four-momentum of the only tight lepton
     unsigned nTight = 0, nLoose = 0;
     
@@ -90,3 +115,76 @@ bool LJetsSelection::ProcessEvent()
     // If the workflow reaches this point, the event is accepted
     return true;
 }
+
+
+bool LJetsSelection::ProcessEventSoA()
+{
+    // Count tight and loose leptons and save four-momentum of the only tight lepton
+    unsigned nTight = 0, nLoose = 0;
+    
+    auto const &electrons = soaReader->GetElectronArrays();
+    
+    for (int i = 0; i < electrons.size; ++i)
+    {
+        if (electrons.pt[i] < ptEleLoose or std::abs(electrons.eta[i]) > 2.4)
+            continue;
+        
+        ++nLoose;
+        
+        if (electrons.pt[i] > ptEleTight)
+        {
+            ++nTight;
+            p4TightLepton.SetPtEtaPhiM(electrons.pt[i], electrons.eta[i], electrons.phi[i], 0.);
+        }
+    }
+    
+    auto const &muons = soaReader->GetMuonArrays();
+    
+    for (int i = 0; i < muons.size; ++i)
+    {
+        if (muons.pt[i] < ptMuLoose or std::abs(muons.eta[i]) > 2.4)
+            continue;
+        
+        ++nLoose;
+        
+        if (muons.pt[i] > ptMuTight)
+        {
+            ++nTight;
+            p4TightLepton.SetPtEtaPhiM(muons.pt[i], muons.eta[i], muons.phi[i], 0.);
+        }
+    }
+    
+    if (nTight != 1 or nLoose != 1)
+        return false;
+    
+    
+    // Count jets. The kinematic selection on them has already been applied by the reader.
+    auto const &jets = soaReader->GetJetArrays();
+    
+    if (jets.size < 4)
+        return false;
+    
+    unsigned nTags = 0;
+    
+    for (int i = 0; i < jets.size; ++i)
+    {
+        if (jets.btag[i] == 1)
+            ++nTags;
+    }
+    
+    if (nTags < 2)
+        return false;
+    
+    
+    // Compute m_T(W) and apply selection on it
+    auto const &met = soaReader->GetMissPt();
+    mtW = std::sqrt(2 * p4TightLepton.Pt() * met.MET *
+      (1 - std::cos(p4TightLepton.Phi() - met.Phi)));
+    
+    if (mtW < mtWThreshold)
+        return false;
+    
+    
+    // If the workflow reaches this point, the event is accepted
+    return true;
+}
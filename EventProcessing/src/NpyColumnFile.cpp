@@ -0,0 +1,91 @@
+#include <NpyColumnFile.hpp>
+
+#include <sstream>
+#include <stdexcept>
+
+
+/// Total size of the .npy header, including the magic string
+static unsigned const headerSize = 128;
+
+
+NpyColumnFile::NpyColumnFile(std::string const &path_):
+    path(path_),
+    output(path_, std::ios::binary),
+    numValues(0),
+    closed(false)
+{
+    if (not output)
+    {
+        std::ostringstream message;
+        message << "NpyColumnFile::NpyColumnFile: Failed to open file \"" << path <<
+          "\" for writing.";
+        throw std::runtime_error(message.str());
+    }
+    
+    buffer.reserve(4096);
+    
+    // Reserve space for the header; it is patched with the actual length in Close
+    WriteHeader(0);
+}
+
+
+NpyColumnFile::~NpyColumnFile()
+{
+    Close();
+}
+
+
+void NpyColumnFile::Append(Float_t value)
+{
+    buffer.push_back(value);
+    
+    if (buffer.size() == buffer.capacity())
+        FlushBuffer();
+}
+
+
+void NpyColumnFile::Close()
+{
+    if (closed)
+        return;
+    
+    closed = true;
+    
+    FlushBuffer();
+    
+    output.seekp(0);
+    WriteHeader(numValues);
+    output.close();
+}
+
+
+void NpyColumnFile::WriteHeader(unsigned long long numValues_)
+{
+    // Version 1.0 of the .npy format: magic string, version, little-endian header length, and
+    //the header dictionary padded with spaces to the fixed total size
+    std::ostringstream dict;
+    dict << "{'descr': '<f4', 'fortran_order': False, 'shape': (" << numValues_ << ",), }";
+    
+    std::string header(dict.str());
+    unsigned const preambleSize = 10;
+    header.resize(headerSize - preambleSize - 1, ' ');
+    header.push_back('\n');
+    
+    unsigned short const headerLength = header.size();
+    
+    output.write("\x93NUMPY\x01\x00", 8);
+    output.write(reinterpret_cast<char const *>(&headerLength), 2);
+    output.write(header.data(), header.size());
+}
+
+
+void NpyColumnFile::FlushBuffer()
+{
+    if (not buffer.empty())
+    {
+        output.write(reinterpret_cast<char const *>(buffer.data()),
+          buffer.size() * sizeof(Float_t));
+        numValues += buffer.size();
+        buffer.clear();
+    }
+}
@@ -9,6 +9,238 @@
 #include <stdexcept>
 
 
+/**
+ * \brief Finds real roots of a quadratic equation a x^2 + b x + c = 0
+ * 
+ * Returns the number of real roots found, counting a double root once. The roots are computed in
+ * a way that avoids the loss of precision from cancellation between -b and the square root of the
+ * discriminant.
+ */
+static unsigned SolveQuadratic(double a, double b, double c, std::array<double, 2> &roots)
+{
+    double const discriminant = b * b - 4 * a * c;
+    
+    if (discriminant < 0.)
+        return 0;
+    
+    if (b == 0. and a == 0.)
+        return 0;
+    
+    double const q = -0.5 * (b + std::copysign(std::sqrt(discriminant), b));
+    
+    if (a != 0. and q != 0.)
+    {
+        roots[0] = q / a;
+        roots[1] = c / q;
+        return 2;
+    }
+    else if (a != 0.)
+    {
+        // Here b == 0 and c <= 0
+        roots[0] = std::sqrt(-c / a);
+        roots[1] = -roots[0];
+        return 2;
+    }
+    else
+    {
+        // The equation is linear
+        roots[0] = -c / b;
+        return 1;
+    }
+}
+
+
+/**
+ * \brief Finds real roots of a cubic equation x^3 + a x^2 + b x + c = 0
+ * 
+ * Returns the number of real roots found. Implements the standard trigonometric and Cardano
+ * solutions, following the prescription from Numerical Recipes.
+ */
+static unsigned SolveCubic(double a, double b, double c, std::array<double, 3> &roots)
+{
+    double const q = (a * a - 3 * b) / 9.;
+    double const r = (2 * std::pow(a, 3) - 9 * a * b + 27 * c) / 54.;
+    
+    if (r * r < std::pow(q, 3))
+    {
+        // Three real roots
+        double const theta = std::acos(r / std::sqrt(std::pow(q, 3)));
+        double const factor = -2 * std::sqrt(q);
+        
+        roots[0] = factor * std::cos(theta / 3) - a / 3;
+        roots[1] = factor * std::cos((theta + 2 * M_PI) / 3) - a / 3;
+        roots[2] = factor * std::cos((theta - 2 * M_PI) / 3) - a / 3;
+        
+        return 3;
+    }
+    else
+    {
+        // Single real root
+        double const s = -std::copysign(
+          std::cbrt(std::abs(r) + std::sqrt(r * r - std::pow(q, 3))), r);
+        double const t = (s != 0.) ? q / s : 0.;
+        
+        roots[0] = s + t - a / 3;
+        return 1;
+    }
+}
+
+
+/**
+ * \brief Finds real roots of a quartic equation p4 x^4 + p3 x^3 + p2 x^2 + p1 x + p0 = 0
+ * 
+ * Returns the number of real roots found. The quartic is factorized into two quadratics with the
+ * help of a resolvent cubic (Descartes--Ferrari method), and the roots are polished with Newton
+ * iterations. When the leading coefficient is smaller in magnitude than the constant term, the
+ * reversed polynomial is solved for 1 / x instead, which avoids the loss of precision caused by a
+ * root of large magnitude. Degenerate leading coefficients are forwarded to the lower-order
+ * solvers.
+ */
+static unsigned SolveQuartic(std::array<double, 5> const &p_, std::array<double, 4> &roots)
+{
+    // Estimate the scale of the coefficients to identify a degenerate leading coefficient
+    double scale = 0.;
+    
+    for (double const c: p_)
+        scale = std::max(scale, std::abs(c));
+    
+    if (scale == 0.)
+        return 0;
+    
+    
+    // Solve for the inverse of the variable if this improves the conditioning
+    bool const reversed = (std::abs(p_[4]) < std::abs(p_[0]));
+    std::array<double, 5> p = p_;
+    
+    if (reversed)
+    {
+        for (unsigned i = 0; i < 5; ++i)
+            p[i] = p_[4 - i];
+    }
+    
+    unsigned numRoots = 0;
+    
+    if (std::abs(p[4]) < 1e-12 * scale)
+    {
+        // The equation is at most cubic
+        if (std::abs(p[3]) < 1e-12 * scale)
+        {
+            std::array<double, 2> quadRoots;
+            numRoots = SolveQuadratic(p[2], p[1], p[0], quadRoots);
+            
+            for (unsigned i = 0; i < numRoots; ++i)
+                roots[i] = quadRoots[i];
+        }
+        else
+        {
+            std::array<double, 3> cubicRoots;
+            numRoots = SolveCubic(p[2] / p[3], p[1] / p[3], p[0] / p[3], cubicRoots);
+            
+            for (unsigned i = 0; i < numRoots; ++i)
+                roots[i] = cubicRoots[i];
+        }
+    }
+    else
+    {
+        // Normalize and depress the quartic with the shift x = y - a3 / 4, which gives
+        //y^4 + b2 y^2 + b1 y + b0 = 0
+        double const a3 = p[3] / p[4], a2 = p[2] / p[4], a1 = p[1] / p[4], a0 = p[0] / p[4];
+        
+        double const b2 = a2 - 3 * a3 * a3 / 8;
+        double const b1 = a1 - a3 * a2 / 2 + std::pow(a3, 3) / 8;
+        double const b0 = a0 - a3 * a1 / 4 + a3 * a3 * a2 / 16 - 3 * std::pow(a3, 4) / 256;
+        
+        if (std::abs(b1) < 1e-12 * (std::abs(b2) + std::abs(b0) + 1.))
+        {
+            // The depressed quartic is biquadratic
+            std::array<double, 2> w;
+            unsigned const n = SolveQuadratic(1., b2, b0, w);
+            
+            for (unsigned i = 0; i < n; ++i)
+            {
+                if (w[i] < 0.)
+                    continue;
+                
+                double const y = std::sqrt(w[i]);
+                roots[numRoots++] = y - a3 / 4;
+                
+                if (y > 0.)
+                    roots[numRoots++] = -y - a3 / 4;
+            }
+        }
+        else
+        {
+            // Solve the resolvent cubic u^3 + 2 b2 u^2 + (b2^2 - 4 b0) u - b1^2 = 0 and pick its
+            //largest real root, which is guaranteed to be positive since the polynomial is
+            //negative at u = 0
+            std::array<double, 3> cubicRoots;
+            unsigned const numCubicRoots = SolveCubic(2 * b2, b2 * b2 - 4 * b0, -b1 * b1,
+              cubicRoots);
+            
+            double u = cubicRoots[0];
+            
+            for (unsigned i = 1; i < numCubicRoots; ++i)
+                u = std::max(u, cubicRoots[i]);
+            
+            if (u <= 0.)
+                return 0;
+            
+            
+            // Factorize the depressed quartic into (y^2 + alpha y + beta)(y^2 - alpha y + gamma)
+            //and solve the two quadratics
+            double const alpha = std::sqrt(u);
+            double const beta = (b2 + u - b1 / alpha) / 2;
+            double const gamma = (b2 + u + b1 / alpha) / 2;
+            
+            std::array<double, 2> quadRoots;
+            unsigned n = SolveQuadratic(1., alpha, beta, quadRoots);
+            
+            for (unsigned i = 0; i < n; ++i)
+                roots[numRoots++] = quadRoots[i] - a3 / 4;
+            
+            n = SolveQuadratic(1., -alpha, gamma, quadRoots);
+            
+            for (unsigned i = 0; i < n; ++i)
+                roots[numRoots++] = quadRoots[i] - a3 / 4;
+        }
+    }
+    
+    
+    // Polish the roots with Newton iterations on the solved polynomial and translate them back
+    //into roots of the original equation if the reversed polynomial has been solved
+    unsigned numFinalRoots = 0;
+    
+    for (unsigned i = 0; i < numRoots; ++i)
+    {
+        double x = roots[i];
+        
+        for (unsigned iter = 0; iter < 2; ++iter)
+        {
+            double const value = (((p[4] * x + p[3]) * x + p[2]) * x + p[1]) * x + p[0];
+            double const derivative = ((4 * p[4] * x + 3 * p[3]) * x + 2 * p[2]) * x + p[1];
+            
+            if (derivative == 0.)
+                break;
+            
+            x -= value / derivative;
+        }
+        
+        if (reversed)
+        {
+            // A root at zero corresponds to a root of the original equation at infinity
+            if (x == 0.)
+                continue;
+            
+            x = 1 / x;
+        }
+        
+        roots[numFinalRoots++] = x;
+    }
+    
+    return numFinalRoots;
+}
+
+
 NuReco::NuReco(double massTop, double massW):
     recoSuccess(false)
 {
@@ -16,6 +248,26 @@ NuReco::NuReco(double massTop, double massW):
 }
 
 
+NuReco::Stats const &NuReco::GetStats() const
+{
+    return stats;
+}
+
+
+void NuReco::MergeStats(Stats const &other) const
+{
+    stats.numSolves += other.numSolves;
+    stats.numUnsolvable += other.numUnsolvable;
+    stats.numGridScanFallbacks += other.numGridScanFallbacks;
+}
+
+
+void NuReco::ResetStats() const
+{
+    stats = Stats();
+}
+
+
 double NuReco::GetCompatibility() const
 {
     return distance;
@@ -31,48 +283,100 @@ TLorentzVector const &NuReco::GetSolution() const
 void NuReco::Reconstruct(TLorentzVector const &p4Lep, TLorentzVector const &p4B,
   TLorentzVector const &p4Miss) const
 {
+    LeptonContext context;
+    PrepareLepton(p4Lep, context);
+    
+    ++stats.numSolves;
+    
+    
     // Construct matrix H, which provides solutions that meet the mass constraints. Abort
     //reconstruction in case of failure.
-    bool const solvable = SolveMassConstraints(p4Lep, p4B);
+    bool const solvable = SolveMassConstraints(context, p4Lep, p4B);
     
     if (not solvable)
     {
+        ++stats.numUnsolvable;
         recoSuccess = false;
         p4Nu.SetXYZM(0, 0, 0, 0);
         return;
     }
     
+    FinishReconstruction(p4Miss);
+}
+
+
+void NuReco::ReconstructBatch(TLorentzVector const &p4Lep,
+  std::vector<TLorentzVector> const &p4Bs, TLorentzVector const &p4Miss,
+  std::vector<Solution> &solutions) const
+{
+    solutions.resize(p4Bs.size());
+    
     
+    // The lepton-side kinematics and rotations are shared by all candidates
+    LeptonContext context;
+    PrepareLepton(p4Lep, context);
+    
+    for (unsigned i = 0; i < p4Bs.size(); ++i)
+    {
+        Solution &solution = solutions[i];
+        ++stats.numSolves;
+        
+        if (not SolveMassConstraints(context, p4Lep, p4Bs[i]))
+        {
+            ++stats.numUnsolvable;
+            solution.status = 1;
+            continue;
+        }
+        
+        FinishReconstruction(p4Miss);
+        
+        solution.status = 0;
+        solution.distance = distance;
+        solution.p4Nu = p4Nu;
+    }
+}
+
+
+void NuReco::FinishReconstruction(TLorentzVector const &p4Miss) const
+{
     // Neutrino momentum in the lab coordinates can be found by applying transformation H to a
     //vector T = (cos(t), sin(t), 1)', where t parameterizes solutions. Now only need to find the
     //solution that matches measured missing pt best.
     
     
-    // Missing pt in matrix form (V0 from Sec. 2.6.1 of the paper, with unconstrained z component)
-    Matrix V0;  // initialized with zeros
-    V0(0, 2) = p4Miss.Px();
-    V0(1, 2) = p4Miss.Py();
-    
-    // Inverted error matrix for missing pt. Use simple identity matrix as the error matrix.
-    Matrix Sigma2 = ROOT::Math::SMatrixIdentity();
-    Sigma2(2, 2) = 0.;
-    
-    // Construct matrix X from Sec. 2.6.1. Compatibility between a solution for the neutrino's
-    //momentum HT and the measured missing pt is quantified by the form T'XT. With the trivial
-    //error matrix used here, this quantity coincides with squared Euclidian distance between the
-    //two transverse momenta.
-    Matrix const Lambda = V0 - H;
-    X = ROOT::Math::Transpose(Lambda) * Sigma2 * Lambda;
-    
-    
-    // Construct matrix M from Sec. 2.6.1. It is used in minimization of T'XT as the derivative of
-    //this quantity with respect to parameter t is T'MT.
-    Matrix D;  // initialized with zeros
-    D(0, 1) = -1.;
-    D(1, 0) = 1.;
-    
-    M = X * D;
-    M += ROOT::Math::Transpose(M);
+    // Compatibility between a solution for the neutrino's momentum HT and the measured missing
+    //pt is quantified by the form T'XT with X = Lambda' Sigma2 Lambda, where Lambda = V0 - H
+    //(Sec. 2.6.1 of the paper). With the trivial error matrix used here, Sigma2 projects onto
+    //the transverse components, so only the first two rows of Lambda contribute, and the form
+    //coincides with the squared Euclidian distance between the two transverse momenta. The
+    //matrix products are expanded into the scalar coefficients of the trigonometric form.
+    double const lambda0[3] = {-H(0, 0), -H(0, 1), p4Miss.Px() - H(0, 2)};
+    double const lambda1[3] = {-H(1, 0), -H(1, 1), p4Miss.Py() - H(1, 2)};
+    
+    double const x00 = lambda0[0] * lambda0[0] + lambda1[0] * lambda1[0];
+    double const x01 = lambda0[0] * lambda0[1] + lambda1[0] * lambda1[1];
+    double const x02 = lambda0[0] * lambda0[2] + lambda1[0] * lambda1[2];
+    double const x11 = lambda0[1] * lambda0[1] + lambda1[1] * lambda1[1];
+    double const x12 = lambda0[1] * lambda0[2] + lambda1[1] * lambda1[2];
+    double const x22 = lambda0[2] * lambda0[2] + lambda1[2] * lambda1[2];
+    
+    lossForm.a = x00;
+    lossForm.b = x11;
+    lossForm.k = x22;
+    lossForm.d = x01;
+    lossForm.e = x02;
+    lossForm.g = x12;
+    
+    
+    // The derivative of T'XT with respect to parameter t is T'MT with M = XD + (XD)', where D is
+    //the fixed antisymmetric differentiation matrix (Sec. 2.6.1). With that structure the
+    //coefficients of M follow directly from those of X.
+    derivativeForm.a = 2 * x01;
+    derivativeForm.b = -2 * x01;
+    derivativeForm.k = 0.;
+    derivativeForm.d = x11 - x00;
+    derivativeForm.e = x12;
+    derivativeForm.g = -x02;
     
     
     // Find value of parameter t that gives the best solution
@@ -116,10 +420,90 @@ void NuReco::SetMasses(double massTop, double massW)
 
 std::pair<double, double> NuReco::Minimize() const
 {
-    Vector T;
-    T[2] = 1.;  // this element will not change
+    std::pair<double, double> minimum;
+    
+    if (MinimizeAnalytic(minimum))
+        return minimum;
+    
+    // Fall back to the iterative scan in degenerate configurations
+    ++stats.numGridScanFallbacks;
+    return MinimizeGridScan();
+}
+
+
+bool NuReco::MinimizeAnalytic(std::pair<double, double> &minimum) const
+{
+    // The derivative of the loss function is the trigonometric polynomial
+    //T'MT = a c^2 + b s^2 + k + 2 d cs + 2 e c + 2 g s, where c and s stand for cos(t) and
+    //sin(t)
+    double const a = derivativeForm.a, b = derivativeForm.b, k = derivativeForm.k;
+    double const d = derivativeForm.d, e = derivativeForm.e, g = derivativeForm.g;
+    
+    
+    // With the substitution z = tan(t / 2), the stationarity condition T'MT = 0, multiplied by
+    //(1 + z^2)^2, becomes a quartic equation in z
+    std::array<double, 5> polynomial;
+    polynomial[4] = a + k - 2 * e;
+    polynomial[3] = 4 * (g - d);
+    polynomial[2] = -2 * a + 4 * b + 2 * k;
+    polynomial[1] = 4 * (d + g);
+    polynomial[0] = a + k + 2 * e;
+    
+    std::array<double, 4> roots;
+    unsigned const numRoots = SolveQuartic(polynomial, roots);
+    
+    if (numRoots == 0)
+        return false;
+    
+    
+    // Translate the roots into values of parameter t and polish each of them with one Newton step
+    //for the stationarity condition. The point t = pi, which the substitution above cannot
+    //represent, is added as an extra candidate; this is harmless when it is not stationary since
+    //candidates are only compared by the value of the loss function below.
+    std::array<double, 5> candidates;
+    unsigned numCandidates = 0;
+    
+    for (unsigned i = 0; i < numRoots; ++i)
+        candidates[numCandidates++] = 2 * std::atan(roots[i]);
+    
+    candidates[numCandidates++] = M_PI;
+    
+    for (unsigned i = 0; i < numCandidates; ++i)
+    {
+        double const c = std::cos(candidates[i]), s = std::sin(candidates[i]);
+        
+        double const derivative = derivativeForm.Evaluate(c, s);
+        double const derivative2 = 2 * (b - a) * c * s + 2 * d * (c * c - s * s) - 2 * e * s +
+          2 * g * c;
+        
+        if (derivative2 != 0.)
+            candidates[i] -= derivative / derivative2;
+    }
     
     
+    // Choose the candidate with the smallest value of the loss function T'XT
+    double minLoss = std::numeric_limits<double>::infinity();
+    double tBest = 0.;
+    
+    for (unsigned i = 0; i < numCandidates; ++i)
+    {
+        double const loss =
+          lossForm.Evaluate(std::cos(candidates[i]), std::sin(candidates[i]));
+        
+        if (loss < minLoss)
+        {
+            minLoss = loss;
+            tBest = candidates[i];
+        }
+    }
+    
+    minimum = std::make_pair(tBest, minLoss);
+    return true;
+}
+
+
+std::pair<double, double> NuReco::MinimizeGridScan() const
+{
     // The loss function can have up to two local minima. First will perform a rough scan over an
     //equidistant grid of points and identify consequitive pairs in which the derivative of the
     //loss function changes sign from negative to positive. They will provide approximate positions
@@ -130,10 +514,7 @@ std::pair<double, double> NuReco::Minimize() const
     
     // Compute the derivative at the initial point
     double t = 0.;
-    T[0] = std::cos(t);
-    T[1] = std::sin(t);
-    
-    double prevDerivative = ROOT::Math::Similarity(M, T);
+    double prevDerivative = derivativeForm.Evaluate(std::cos(t), std::sin(t));
     
     // Positions of centres of identified pairs of points will be stored in an array. Do not use a
     //vector in order to avoid dynamic memory allocation. This is possible since the loss function
@@ -148,10 +529,7 @@ std::pair<double, double> NuReco::Minimize() const
     for (unsigned iPoint = 1; iPoint <= nPoints; ++iPoint, t += step)
     {
         // Compute derivative at the new point
-        T[0] = std::cos(t);
-        T[1] = std::sin(t);
-        
-        double const newDerivative = ROOT::Math::Similarity(M, T);
+        double const newDerivative = derivativeForm.Evaluate(std::cos(t), std::sin(t));
         
         
         // Check if signs of the derivatives are compatible with the hypothesis that there is a
@@ -170,7 +548,7 @@ std::pair<double, double> NuReco::Minimize() const
     }
     
     if (nMinima == 0)
-        throw std::logic_error("NuReco::Minimize: Failed to find approximate position of a "
+        throw std::logic_error("NuReco::MinimizeGridScan: Failed to find approximate position of a "
           "minimum in a grid search.");
     
     
@@ -189,10 +567,7 @@ std::pair<double, double> NuReco::Minimize() const
         {
             t0 = (tMin + tMax) / 2;
             
-            T[0] = std::cos(t0);
-            T[1] = std::sin(t0);
-            
-            double const fD = ROOT::Math::Similarity(M, T);
+            double const fD = derivativeForm.Evaluate(std::cos(t0), std::sin(t0));
             
             if (fD > 0.)
             {
@@ -208,10 +583,7 @@ std::pair<double, double> NuReco::Minimize() const
         //estimate for the global minimum
         t0 = (tMin + tMax) / 2;
         
-        T[0] = std::cos(t0);
-        T[1] = std::sin(t0);
-        
-        double const f = ROOT::Math::Similarity(X, T);
+        double const f = lossForm.Evaluate(std::cos(t0), std::sin(t0));
         
         if (f < minF)
         {
@@ -266,7 +638,32 @@ NuReco::Matrix NuReco::Rotation(unsigned axis, double angle)
 }
 
 
-bool NuReco::SolveMassConstraints(TLorentzVector const &p4Lep, TLorentzVector const &p4B) const
+void NuReco::PrepareLepton(TLorentzVector const &p4Lep, LeptonContext &context) const
+{
+    // Eq. 2 from the paper
+    context.x0 = -(massW2 - p4Lep.M2()) / (2 * p4Lep.E());
+    
+    // Relativistic beta and momentum
+    context.betaLep = p4Lep.Beta();
+    context.pLep = p4Lep.P();
+    
+    // $\epsilon^2$ from the end of Sec. 2.2
+    context.epsilon2 = massW2 * (1 - context.betaLep * context.betaLep);
+    
+    // Eq. 6
+    context.Sx = (context.x0 * context.betaLep -
+      context.pLep * (1 - context.betaLep * context.betaLep)) /
+      (context.betaLep * context.betaLep);
+    
+    // Rotations about the z and y axes from Sec. 2.5
+    Matrix const Rz = Rotation(2, -p4Lep.Phi());
+    Matrix const Ry = Rotation(1, M_PI / 2 - p4Lep.Theta());
+    context.RyRz = Ry * Rz;
+}
+
+
+bool NuReco::SolveMassConstraints(LeptonContext const &context, TLorentzVector const &p4Lep,
+  TLorentzVector const &p4B) const
 {
     // Implementation closely follows the paper
     
@@ -276,16 +673,16 @@ bool NuReco::SolveMassConstraints(TLorentzVector const &p4Lep, TLorentzVector co
     
     // Eq. 2 from the paper
     double const x0p = -(massTop2 - massW2 - p4B.M2()) / (2 * p4B.E());
-    double const x0 = -(massW2 - p4Lep.M2()) / (2 * p4Lep.E());
+    double const x0 = context.x0;
     
     // Relativistic beta
-    double const betaLep = p4Lep.Beta(), betaB = p4B.Beta();
+    double const betaLep = context.betaLep, betaB = p4B.Beta();
     
     // $\epsilon^2$ from the end of Sec. 2.2
-    double const epsilon2 = massW2 * (1 - betaLep * betaLep);
+    double const epsilon2 = context.epsilon2;
     
     // Eq. 6 and expression for Sy from Sec. 2.4.2
-    double const Sx = (x0 * betaLep - p4Lep.P() * (1 - betaLep * betaLep)) / (betaLep * betaLep);
+    double const Sx = context.Sx;
     double const Sy = (x0p / betaB - c * Sx) / s;
     
     // $\omega$ from Sec. 2.4.2 (the variable with minus sign is not used)
@@ -312,26 +709,24 @@ bool NuReco::SolveMassConstraints(TLorentzVector const &p4Lep, TLorentzVector co
     Matrix Htilde;  // initialized with zeros
     
     Htilde(0, 0) = Z / std::sqrt(Omega2);
-    Htilde(0, 2) = x1 - p4Lep.P();
+    Htilde(0, 2) = x1 - context.pLep;
     Htilde(1, 0) = omega * Z / std::sqrt(Omega2);
     Htilde(1, 2) = y1;
     Htilde(2, 1) = Z;
     
     
     // Construct rotation matrix R from Sec. 2.5. Implementation follows the reference Python
-    //implementation from the Appendix.
-    Matrix const Rz = Rotation(2, -p4Lep.Phi());
-    Matrix const Ry = Rotation(1, M_PI / 2 - p4Lep.Theta());
-    
+    //implementation from the Appendix; the product of the lepton-side rotations is taken from
+    //the precomputed context.
     Vector p3B;
     p3B[0] = p4B.Px();
     p3B[1] = p4B.Py();
     p3B[2] = p4B.Pz();
     
-    Vector const p3BRotated = Ry * Rz * p3B;
+    Vector const p3BRotated = context.RyRz * p3B;
     Matrix const Rx = Rotation(0, -std::atan2(p3BRotated[2], p3BRotated[1]));
     
-    Matrix const R = ROOT::Math::Transpose(Rx * Ry * Rz);
+    Matrix const R = ROOT::Math::Transpose(Rx * context.RyRz);
     
     
     // Finally, build matrix H from Sec. 2.5
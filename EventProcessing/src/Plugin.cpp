@@ -14,6 +14,16 @@ void Plugin::EndFile()
 {}
 
 
+Plugin *Plugin::Clone() const
+{
+    return nullptr;
+}
+
+
+void Plugin::RebindPlugin(Plugin const *, Plugin const *)
+{}
+
+
 void Plugin::SetProcessor(Processor *processor_)
 {
     processor = processor_;
@@ -1,16 +1,86 @@
 #include <Processor.hpp>
 
+#include <AsyncTreeWriter.hpp>
+#include <DelphesReaderBase.hpp>
+#include <EntryListCache.hpp>
+#include <HistogramBuffer.hpp>
 #include <Plugin.hpp>
+#include <SPSCQueue.hpp>
+
+#include <TH1D.h>
+#include <TROOT.h>
+#include <TTree.h>
 
 #include <boost/filesystem.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <mutex>
 #include <regex>
+#include <thread>
+#include <typeinfo>
+
+#include <cxxabi.h>
+
+
+/// Protects concurrent appends to the journal of completed input files
+static std::mutex journalMutex;
+
+
+/// Checks whether the given path refers to a remote resource
+static bool IsRemotePath(std::string const &path)
+{
+    return (path.find("://") != std::string::npos);
+}
+
+
+/// Returns the path of the journal of completed input files
+static std::string JournalPath(std::string const &outputDir)
+{
+    return (boost::filesystem::path(outputDir) / "processed.journal").string();
+}
+
+
+/// Returns a human-readable name of the dynamic type of the given plugin
+static std::string PluginName(Plugin const &plugin)
+{
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(typeid(plugin).name(), nullptr, nullptr, &status);
+    
+    if (status != 0 or not demangled)
+        return typeid(plugin).name();
+    
+    std::string name(demangled);
+    std::free(demangled);
+    
+    return name;
+}
+
+
+Processor::PluginStats::PluginStats(std::string const &name_):
+    name(name_),
+    numCalls(0), numOk(0), numRejected(0),
+    wallTime(0.)
+{}
 
 
 Processor::Processor(std::string const &fileMask_):
-    createOutputFile(false)
+    createOutputFile(false),
+    mergedOutput(false),
+    resumeMode(false), incrementalMode(false),
+    numWorkers(1),
+    asyncOutput(false),
+    prefetchFiles(false),
+    stagingEnabled(false), maxStagedFiles(2), stagingStop(false),
+    pipelinedReading(false),
+    selectionBoundary(nullptr), selectionBoundaryIndex(-1),
+    profiling(false),
+    suppressProfileReport(false)
 {
     namespace fs = boost::filesystem;
     
@@ -51,16 +121,25 @@ Processor::Processor(std::string const &fileMask_):
     std::regex filenameRegex(filenameMask);
     
     
-    // Check all files in the directory against the constructed regular expression
+    // Check all files in the directory against the constructed regular expression. The matches
+    //are sorted so that the resulting queue does not depend on the order of the directory
+    //listing, which makes sharding deterministic.
+    std::vector<std::string> matchedFiles;
+    
     for (fs::directory_iterator dirIt(directory); dirIt != fs::directory_iterator(); ++dirIt)
     {
         if (not fs::is_regular_file(dirIt->status()))
             continue;
         
         if (std::regex_match(dirIt->path().filename().string(), filenameRegex))
-            inputFiles.push(dirIt->path().string());
+            matchedFiles.push_back(dirIt->path().string());
     }
     
+    std::sort(matchedFiles.begin(), matchedFiles.end());
+    
+    for (auto const &file: matchedFiles)
+        inputFiles.push(file);
+    
     if (inputFiles.empty())
     {
         std::ostringstream message;
@@ -70,13 +149,192 @@ Processor::Processor(std::string const &fileMask_):
 }
 
 
+Processor::Processor():
+    createOutputFile(false),
+    mergedOutput(false),
+    resumeMode(false), incrementalMode(false),
+    numWorkers(1),
+    asyncOutput(false),
+    prefetchFiles(false),
+    stagingEnabled(false), maxStagedFiles(2), stagingStop(false),
+    pipelinedReading(false),
+    selectionBoundary(nullptr), selectionBoundaryIndex(-1),
+    profiling(false),
+    suppressProfileReport(false)
+{}
+
+
+Processor::~Processor()
+{
+    StopStaging();
+    
+    // Dispose of a file opened by the prefetching task if it has not been consumed
+    if (prefetchedFile.valid())
+    {
+        try
+        {
+            delete prefetchedFile.get();
+        }
+        catch (...)
+        {}
+    }
+}
+
+
+AsyncTreeWriter *Processor::BookAsyncTree(std::string const &inFileDirectory,
+  std::string const &name, std::string const &title)
+{
+    TTree *tree = Book<TTree>(inFileDirectory, name.c_str(), title.c_str());
+    
+    // With a merged output file the booking may have returned an already wrapped tree
+    for (auto const &writer: asyncWriters)
+    {
+        if (writer->GetTree() == tree)
+            return writer.get();
+    }
+    
+    asyncWriters.emplace_back(new AsyncTreeWriter(tree, asyncOutput));
+    asyncWriters.back()->SetWriteOptions(treeWriteOptions);
+    
+    return asyncWriters.back().get();
+}
+
+
+HistogramBuffer *Processor::BookHistogram(std::string const &inFileDirectory,
+  std::string const &name, std::string const &title, std::vector<double> const &binning)
+{
+    // Return the existing handle when the histogram has been declared before
+    for (auto const &buffer: histogramBuffers)
+    {
+        if (buffer->Name() == name and buffer->Directory() == inFileDirectory)
+            return buffer.get();
+    }
+    
+    histogramBuffers.emplace_back(
+      new HistogramBuffer(inFileDirectory, name, title, binning));
+    
+    return histogramBuffers.back().get();
+}
+
+
+HistogramBuffer *Processor::BookHistogram(std::string const &inFileDirectory,
+  std::string const &name, std::string const &title, unsigned numBins, double xMin, double xMax)
+{
+    std::vector<double> binning;
+    binning.reserve(numBins + 1);
+    
+    for (unsigned i = 0; i <= numBins; ++i)
+        binning.push_back(xMin + (xMax - xMin) * i / numBins);
+    
+    return BookHistogram(inFileDirectory, name, title, binning);
+}
+
+
+void Processor::SetAsyncOutput(bool on)
+{
+    asyncOutput = on;
+}
+
+
+void Processor::SetTreeWriteOptions(TreeWriteOptions const &options)
+{
+    treeWriteOptions = options;
+}
+
+
+void Processor::SetSelectionCache(std::string const &tag, Plugin const *boundaryPlugin)
+{
+    selectionCacheTag = tag;
+    selectionBoundary = boundaryPlugin;
+}
+
+
+void Processor::SetPipelinedReading(bool on)
+{
+    pipelinedReading = on;
+    
+    if (on)
+    {
+        // The producer thread accesses ROOT objects
+        ROOT::EnableThreadSafety();
+    }
+}
+
+
+void Processor::SetProfiling(bool on)
+{
+    profiling = on;
+}
+
+
+void Processor::SetProfileJSONOutput(std::string const &path)
+{
+    profileJSONPath = path;
+    profiling = true;
+}
+
+
+std::vector<std::string> Processor::ReadFileList(std::string const &path)
+{
+    std::ifstream input(path);
+    
+    if (not input)
+    {
+        std::ostringstream message;
+        message << "Processor::ReadFileList: Failed to open file \"" << path <<
+          "\" for reading.";
+        throw std::runtime_error(message.str());
+    }
+    
+    std::vector<std::string> files;
+    std::string line;
+    
+    while (std::getline(input, line))
+    {
+        if (not line.empty() and line[0] != '#')
+            files.push_back(line);
+    }
+    
+    return files;
+}
+
+
+void Processor::SetStagingCache(std::string const &directory, unsigned maxStagedFiles_)
+{
+    stagingEnabled = true;
+    stagingDir = directory;
+    maxStagedFiles = std::max(1u, maxStagedFiles_);
+}
+
+
+void Processor::SetFilePrefetching(bool on)
+{
+    prefetchFiles = on;
+    
+    if (on)
+    {
+        // The prefetching task accesses ROOT objects from a background thread
+        ROOT::EnableThreadSafety();
+    }
+}
+
+
 void Processor::SetOutput(std::string const outputDir_)
 {
     createOutputFile = true;
+    mergedOutput = false;
     outputDir = outputDir_;
 }
 
 
+void Processor::SetMergedOutput(std::string const &fileName)
+{
+    createOutputFile = true;
+    mergedOutput = true;
+    mergedOutputFileName = fileName;
+}
+
+
 void Processor::RegisterPlugin(Plugin *plugin)
 {
     plugin->SetProcessor(this);
@@ -86,11 +344,88 @@ void Processor::RegisterPlugin(Plugin *plugin)
 
 void Processor::Run()
 {
-    // Create directory for output files if needed
-    if (createOutputFile)
+    // Delegate to worker threads if concurrent processing has been requested
+    if (numWorkers > 1)
+    {
+        RunParallel();
+        return;
+    }
+    
+    
+    if ((resumeMode or incrementalMode) and (not createOutputFile or mergedOutput))
+    {
+        std::ostringstream message;
+        message << "Processor::Run: The resume and incremental modes require per-file output "
+          "files.";
+        throw std::runtime_error(message.str());
+    }
+    
+    
+    // Create the output file or the directory for per-file outputs
+    if (mergedOutput)
+    {
+        auto const parentDir = boost::filesystem::path(mergedOutputFileName).parent_path();
+        
+        if (not parentDir.empty())
+            boost::filesystem::create_directories(parentDir);
+        
+        curOutputFile.reset(TFile::Open(mergedOutputFileName.c_str(), "create"));
+        
+        if (not curOutputFile or curOutputFile->IsZombie())
+        {
+            std::ostringstream message;
+            message << "Processor::Run: Failed to open file \"" << mergedOutputFileName <<
+              "\" for writing.";
+            
+            if (boost::filesystem::exists(mergedOutputFileName))
+                message << " The file already exists.";
+            
+            throw std::runtime_error(message.str());
+        }
+    }
+    else if (createOutputFile)
         boost::filesystem::create_directories(outputDir);
     
     
+    // Load the journal of completed input files left by a previous job
+    if (resumeMode)
+        LoadJournal();
+    
+    
+    // Set up the persistent selection cache
+    DelphesReaderBase *selectionReader = nullptr;
+    
+    if (not selectionCacheTag.empty())
+    {
+        if (pipelinedReading)
+        {
+            std::ostringstream message;
+            message << "Processor::Run: The selection cache is not available together with "
+              "pipelined reading.";
+            throw std::runtime_error(message.str());
+        }
+        
+        selectionReader =
+          (path.empty()) ? nullptr : dynamic_cast<DelphesReaderBase *>(path.front());
+        
+        if (not selectionReader)
+        {
+            std::ostringstream message;
+            message << "Processor::Run: The selection cache requires the first plugin of the "
+              "path to derive from DelphesReaderBase.";
+            throw std::runtime_error(message.str());
+        }
+        
+        ResolveSelectionBoundary();
+    }
+    
+    if (profiling)
+        InitializeProfile();
+    
+    if (stagingEnabled)
+        StartStaging();
+    
+    
     // Loop over input files
     while (OpenNextFile())
     {
@@ -99,25 +434,96 @@ void Processor::Run()
             p->BeginFile(curInputFile.get());
         
         
+        // Replay the cached selection for this file, or record a new one
+        bool recordingSelection = false;
+        std::vector<long long> recordedSelectionEntries;
+        
+        if (selectionReader)
+        {
+            std::string const cachePath =
+              EntryListCache::BuildPath(curInputFileName, selectionCacheTag);
+            std::vector<long long> cachedEntries;
+            
+            if (EntryListCache::Load(cachePath, selectionCacheTag,
+              selectionReader->GetNumEvents(), cachedEntries))
+                selectionReader->UseEntryList(cachedEntries);
+            else
+                recordingSelection = true;
+        }
+        
+        
         // Loop over events in the current input file
-        bool noEvents = false;
+        auto const fileStartTime = std::chrono::steady_clock::now();
+        unsigned long long numEventsInFile = 0;
         
-        while (not noEvents)
+        if (pipelinedReading)
+        {
+            DelphesReaderBase *reader =
+              (path.empty()) ? nullptr : dynamic_cast<DelphesReaderBase *>(path.front());
+            
+            if (not reader)
+            {
+                std::ostringstream message;
+                message << "Processor::Run: The pipelined mode requires the first plugin of "
+                  "the path to derive from DelphesReaderBase.";
+                throw std::runtime_error(message.str());
+            }
+            
+            numEventsInFile = ProcessFilePipelined(reader);
+        }
+        else
         {
-            // Process current event through all plugins
-            for (auto &p: path)
+            bool noEvents = false;
+            
+            while (not noEvents)
             {
-                Plugin::EventOutcome const res = p->ProcessEventToOutcome();
+                // Process current event through all plugins
+                int rejectedAt = -1;
                 
-                if (res == Plugin::EventOutcome::NoEvents)
+                for (unsigned iPlugin = 0; iPlugin < path.size(); ++iPlugin)
                 {
-                    noEvents = true;
-                    break;
+                    Plugin::EventOutcome res;
+                    
+                    if (profiling)
+                    {
+                        auto const startTime = std::chrono::steady_clock::now();
+                        res = path[iPlugin]->ProcessEventToOutcome();
+                        auto const stopTime = std::chrono::steady_clock::now();
+                        
+                        PluginStats &stats = pluginStats[iPlugin];
+                        stats.wallTime +=
+                          std::chrono::duration<double>(stopTime - startTime).count();
+                        ++stats.numCalls;
+                        
+                        if (res == Plugin::EventOutcome::Ok)
+                            ++stats.numOk;
+                        else if (res == Plugin::EventOutcome::Rejected)
+                            ++stats.numRejected;
+                    }
+                    else
+                        res = path[iPlugin]->ProcessEventToOutcome();
+                    
+                    if (res == Plugin::EventOutcome::NoEvents)
+                    {
+                        noEvents = true;
+                        break;
+                    }
+                    else if (res == Plugin::EventOutcome::Rejected)
+                    {
+                        // Event has been rejected. Do not execute remaining plugins for it.
+                        rejectedAt = iPlugin;
+                        break;
+                    }
                 }
-                else if (res == Plugin::EventOutcome::Rejected)
+                
+                if (not noEvents)
                 {
-                    // Event has been rejected. Do not execute remaining plugins for it.
-                    break;
+                    ++numEventsInFile;
+                    
+                    // Record entries of events that survive the selection up to the boundary
+                    if (recordingSelection and
+                      (rejectedAt < 0 or rejectedAt > selectionBoundaryIndex))
+                        recordedSelectionEntries.push_back(selectionReader->GetReadEntry());
                 }
             }
         }
@@ -126,64 +532,900 @@ void Processor::Run()
         // Notify all plugins that the current input file is about to be closed
         for (auto pIt = path.rbegin(); pIt != path.rend(); ++pIt)
             (*pIt)->EndFile();
+        
+        
+        // Persist the recorded selection so that subsequent jobs can replay it
+        if (recordingSelection)
+            EntryListCache::Save(
+              EntryListCache::BuildPath(curInputFileName, selectionCacheTag),
+              selectionCacheTag, selectionReader->GetNumEvents(), recordedSelectionEntries);
+        
+        
+        // Turn the histogram buffers into ROOT histograms in the output file
+        if (createOutputFile and not histogramBuffers.empty())
+            MaterializeBookedHistograms();
+        
+        
+        if (profiling)
+        {
+            double const elapsed =
+              std::chrono::duration<double>(std::chrono::steady_clock::now() -
+              fileStartTime).count();
+            
+            std::cout << "  Read " << numEventsInFile << " events in " << elapsed << " s";
+            
+            if (elapsed > 0.)
+                std::cout << " (" << numEventsInFile / elapsed << " events/s)";
+            
+            std::cout << std::endl;
+        }
     }
-}
-
-
-bool Processor::OpenNextFile()
-{
-    // Close previous input and output files
-    if (curInputFile)
-        curInputFile->Close();
     
-    if (curOutputFile)
+    
+    StopStaging();
+    
+    
+    // Write out the merged output file
+    if (mergedOutput and curOutputFile)
     {
+        // Make sure all pending events have been written into the output trees
+        for (auto const &writer: asyncWriters)
+            writer->Flush();
+        
         curOutputFile->Write();
+        
+        // Storage statistics are only complete once all baskets have been flushed by Write
+        CollectTreeStats();
+        asyncWriters.clear();
+        
         curOutputFile->Close();
+        curOutputFile.reset();
     }
     
     
-    // Check if there are input files left
-    if (inputFiles.empty())
-        return false;
-    
-    
-    // Open the next input file
-    std::string const inputFileName(inputFiles.front());
-    curInputFile.reset(TFile::Open(inputFileName.c_str()));
-    
-    if (not curInputFile or curInputFile->IsZombie())
+    // Report the collected statistics unless this is a worker processor, in which case the
+    //parent aggregates and reports them
+    if (profiling and not suppressProfileReport)
+    {
+        ReportProfile();
+        
+        if (not profileJSONPath.empty())
+            WriteProfileJSON();
+    }
+}
+
+
+void Processor::SetIncremental(bool on)
+{
+    incrementalMode = on;
+}
+
+
+void Processor::SetResume(bool on)
+{
+    resumeMode = on;
+}
+
+
+void Processor::SetSharding(unsigned numShards, unsigned shardIndex)
+{
+    if (numShards == 0 or shardIndex >= numShards)
     {
         std::ostringstream message;
-        message << "Processor::OpenNextFile: Failed to open file \"" << inputFileName <<
-          "\" for reading.";
+        message << "Processor::SetSharding: Illegal shard index " << shardIndex << " for " <<
+          numShards << " shards.";
         throw std::runtime_error(message.str());
     }
     
-    std::cout << "Processing file \"" << inputFileName << "\"..." << std::endl;
-    inputFiles.pop();
     
+    // Keep every numShards-th file, starting from the given index
+    std::queue<std::string> selectedFiles;
+    unsigned long long index = 0;
     
-    // Create output file
-    if (createOutputFile)
+    while (not inputFiles.empty())
     {
-        auto const inputBaseName = boost::filesystem::path(inputFileName).filename();
-        auto const outFileName = (boost::filesystem::path(outputDir) / inputBaseName).string();
+        if (index % numShards == shardIndex)
+            selectedFiles.push(inputFiles.front());
         
-        curOutputFile.reset(TFile::Open(outFileName.c_str(), "create"));
+        inputFiles.pop();
+        ++index;
+    }
+    
+    inputFiles = std::move(selectedFiles);
+}
+
+
+void Processor::SetNumWorkers(unsigned numWorkers_)
+{
+    if (numWorkers_ == 0)
+    {
+        std::ostringstream message;
+        message << "Processor::SetNumWorkers: Number of workers must not be zero.";
+        throw std::runtime_error(message.str());
+    }
+    
+    numWorkers = numWorkers_;
+}
+
+
+bool Processor::OpenNextFile()
+{
+    // Close previous input and output files. With a merged output, the output file stays open
+    //until the whole queue has been processed.
+    if (curInputFile)
+    {
+        curInputFile->Close();
         
-        if (not curOutputFile or curOutputFile->IsZombie())
+        // Evict the staged local copy of the processed file
+        if (not curStagedFile.empty())
         {
-            std::ostringstream message;
-            message << "Failed to open file \"" << outFileName << "\" for writing.";
+            boost::filesystem::remove(curStagedFile);
             
-            if (boost::filesystem::exists(outFileName))
-                message << " The file already exists.";
+            {
+                std::lock_guard<std::mutex> lock(stagingMutex);
+                stagedFiles.erase(curStagedRemote);
+            }
             
-            throw std::runtime_error(message.str());
+            curStagedFile.clear();
+            curStagedRemote.clear();
+            stagingCondition.notify_all();
         }
     }
     
-    
+    if (curOutputFile and not mergedOutput)
+    {
+        // Make sure all pending events have been written into the output trees
+        for (auto const &writer: asyncWriters)
+            writer->Flush();
+        
+        curOutputFile->Write();
+        
+        // Storage statistics are only complete once all baskets have been flushed by Write
+        CollectTreeStats();
+        asyncWriters.clear();
+        
+        curOutputFile->Close();
+        
+        if (resumeMode)
+        {
+            // The output is complete; give it its final name and record the input file in the
+            //journal
+            boost::filesystem::rename(curOutputFileName + ".inprogress", curOutputFileName);
+            
+            std::lock_guard<std::mutex> lock(journalMutex);
+            std::ofstream journal(JournalPath(outputDir), std::ios::app);
+            journal << curInputFileName << '\n';
+        }
+    }
+    
+    
+    // Find the next input file to process, skipping completed or up-to-date ones in the resume
+    //and incremental modes
+    while (true)
+    {
+        if (inputFiles.empty())
+            return false;
+        
+        if (not resumeMode and not incrementalMode)
+            break;
+        
+        std::string const &candidate = inputFiles.front();
+        auto const outPath = boost::filesystem::path(outputDir) /
+          boost::filesystem::path(candidate).filename();
+        bool skip = false;
+        
+        if (resumeMode and processedInputs.count(candidate) > 0 and
+          boost::filesystem::exists(outPath))
+            skip = true;
+        
+        if (incrementalMode and boost::filesystem::exists(outPath) and
+          boost::filesystem::last_write_time(candidate) <=
+          boost::filesystem::last_write_time(outPath))
+            skip = true;
+        
+        if (not skip)
+            break;
+        
+        std::cout << "Skipping file \"" << candidate << "\": output is up to date." <<
+          std::endl;
+        
+        // Drop any staging work associated with the skipped file so that it does not occupy a
+        //slot of the bounded cache
+        if (stagingEnabled and IsRemotePath(candidate))
+        {
+            std::string stagedCopy;
+            
+            {
+                std::lock_guard<std::mutex> lock(stagingMutex);
+                
+                auto const queueIt =
+                  std::find(stagingQueue.begin(), stagingQueue.end(), candidate);
+                
+                if (queueIt != stagingQueue.end())
+                    stagingQueue.erase(queueIt);
+                
+                auto const stagedIt = stagedFiles.find(candidate);
+                
+                if (stagedIt != stagedFiles.end())
+                {
+                    stagedCopy = stagedIt->second;
+                    stagedFiles.erase(stagedIt);
+                }
+                else
+                {
+                    // The file might be staged right now; mark its result as unwanted
+                    discardedStaging.insert(candidate);
+                }
+            }
+            
+            if (not stagedCopy.empty())
+                boost::filesystem::remove(stagedCopy);
+            
+            stagingCondition.notify_all();
+        }
+        
+        inputFiles.pop();
+    }
+    
+    
+    // Open the next input file, taking it from the prefetching task when possible
+    std::string const inputFileName(inputFiles.front());
+    
+    if (stagingEnabled and IsRemotePath(inputFileName))
+    {
+        // Wait until the staging thread has produced a local copy of the file
+        std::string localPath;
+        
+        {
+            std::unique_lock<std::mutex> lock(stagingMutex);
+            stagingCondition.wait(lock,
+              [&]{return stagedFiles.count(inputFileName) > 0;});
+            localPath = stagedFiles[inputFileName];
+        }
+        
+        if (localPath.empty())
+        {
+            // Staging has failed; stream the file directly. The failure marker is dropped so
+            //that it does not occupy a slot of the bounded cache.
+            {
+                std::lock_guard<std::mutex> lock(stagingMutex);
+                stagedFiles.erase(inputFileName);
+            }
+            
+            stagingCondition.notify_all();
+            curInputFile.reset(TFile::Open(inputFileName.c_str()));
+        }
+        else
+        {
+            curInputFile.reset(TFile::Open(localPath.c_str()));
+            curStagedFile = localPath;
+            curStagedRemote = inputFileName;
+        }
+    }
+    else if (prefetchedFile.valid() and prefetchedFileName == inputFileName)
+        curInputFile.reset(prefetchedFile.get());
+    else
+    {
+        // Dispose of a stale prefetched file if the queue got out of sync with the prefetching
+        if (prefetchedFile.valid())
+            delete prefetchedFile.get();
+        
+        curInputFile.reset(TFile::Open(inputFileName.c_str()));
+    }
+    
+    if (not curInputFile or curInputFile->IsZombie())
+    {
+        std::ostringstream message;
+        message << "Processor::OpenNextFile: Failed to open file \"" << inputFileName <<
+          "\" for reading.";
+        throw std::runtime_error(message.str());
+    }
+    
+    std::cout << "Processing file \"" << inputFileName << "\"..." << std::endl;
+    curInputFileName = inputFileName;
+    inputFiles.pop();
+    
+    
+    // Start opening the next file in the queue on a background thread. Reading the header of the
+    //Delphes tree warms up the file so that the setup of branch buffers is fast as well.
+    if (prefetchFiles and not inputFiles.empty() and
+      not (stagingEnabled and IsRemotePath(inputFiles.front())))
+    {
+        prefetchedFileName = inputFiles.front();
+        prefetchedFile = std::async(std::launch::async,
+          [](std::string const &path) -> TFile *
+          {
+              TFile *file = TFile::Open(path.c_str());
+              
+              if (file and not file->IsZombie())
+                  file->Get("Delphes");
+              
+              return file;
+          },
+          prefetchedFileName);
+    }
+    
+    
+    // Create output file. In the resume mode it is written through a temporary name, which is
+    //only replaced with the final one when the input file has been fully processed; leftovers
+    //of an interrupted job are simply overwritten.
+    if (createOutputFile and not mergedOutput)
+    {
+        auto const inputBaseName = boost::filesystem::path(inputFileName).filename();
+        auto const outFileName = (boost::filesystem::path(outputDir) / inputBaseName).string();
+        
+        curOutputFileName = outFileName;
+        
+        if (resumeMode)
+            curOutputFile.reset(TFile::Open((outFileName + ".inprogress").c_str(), "recreate"));
+        else
+            curOutputFile.reset(TFile::Open(outFileName.c_str(), "create"));
+        
+        if (not curOutputFile or curOutputFile->IsZombie())
+        {
+            std::ostringstream message;
+            message << "Failed to open file \"" << outFileName << "\" for writing.";
+            
+            if (not resumeMode and boost::filesystem::exists(outFileName))
+                message << " The file already exists.";
+            
+            throw std::runtime_error(message.str());
+        }
+    }
+    
+    
     return true;
 }
+
+
+void Processor::RunParallel()
+{
+    if (mergedOutput)
+    {
+        std::ostringstream message;
+        message << "Processor::RunParallel: A merged output file is not supported with "
+          "multiple workers.";
+        throw std::runtime_error(message.str());
+    }
+    
+    if ((resumeMode or incrementalMode) and not createOutputFile)
+    {
+        std::ostringstream message;
+        message << "Processor::RunParallel: The resume and incremental modes require per-file "
+          "output files.";
+        throw std::runtime_error(message.str());
+    }
+    
+    if (resumeMode)
+        LoadJournal();
+    
+    if (not selectionCacheTag.empty())
+        ResolveSelectionBoundary();
+    
+    
+    // Make ROOT usable from multiple threads
+    ROOT::EnableThreadSafety();
+    
+    
+    // Create directory for output files if needed
+    if (createOutputFile)
+        boost::filesystem::create_directories(outputDir);
+    
+    
+    // Create a private processor for each worker. Each of them runs a clone of the plugin path
+    //and takes over the output configuration, while its queue of input files is kept empty; files
+    //are fed to it one by one below.
+    std::vector<std::unique_ptr<Processor>> workers;
+    std::vector<std::vector<std::unique_ptr<Plugin>>> clonedPaths(numWorkers);
+    
+    for (unsigned iWorker = 0; iWorker < numWorkers; ++iWorker)
+    {
+        std::unique_ptr<Processor> worker(new Processor);
+        worker->createOutputFile = createOutputFile;
+        worker->outputDir = outputDir;
+        worker->asyncOutput = asyncOutput;
+        worker->treeWriteOptions = treeWriteOptions;
+        worker->pipelinedReading = pipelinedReading;
+        worker->selectionCacheTag = selectionCacheTag;
+        worker->selectionBoundaryIndex = selectionBoundaryIndex;
+        worker->resumeMode = resumeMode;
+        worker->incrementalMode = incrementalMode;
+        worker->processedInputs = processedInputs;
+        worker->profiling = profiling;
+        worker->suppressProfileReport = true;
+        
+        auto &clones = clonedPaths[iWorker];
+        
+        for (unsigned iPlugin = 0; iPlugin < path.size(); ++iPlugin)
+        {
+            Plugin *clone = path[iPlugin]->Clone();
+            
+            if (not clone)
+            {
+                std::ostringstream message;
+                message << "Processor::RunParallel: Plugin #" << iPlugin << " in the path does "
+                  "not support cloning, which is required for concurrent processing.";
+                throw std::runtime_error(message.str());
+            }
+            
+            // Redirect pointers to other plugins from the original path to the clones
+            for (unsigned j = 0; j < iPlugin; ++j)
+                clone->RebindPlugin(path[j], clones[j].get());
+            
+            clones.emplace_back(clone);
+            worker->RegisterPlugin(clone);
+        }
+        
+        workers.emplace_back(std::move(worker));
+    }
+    
+    
+    // Feed input files to the workers. Each worker thread pops paths from the shared queue and
+    //processes the corresponding files one at a time. The first exception thrown in a worker
+    //thread is rethrown after all threads have finished.
+    std::mutex queueMutex;
+    std::exception_ptr workerException;
+    
+    auto workerLoop = [&](Processor *workerProcessor)
+    {
+        try
+        {
+            while (true)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(queueMutex);
+                    
+                    if (inputFiles.empty() or workerException)
+                        break;
+                    
+                    workerProcessor->inputFiles.push(inputFiles.front());
+                    inputFiles.pop();
+                }
+                
+                // The queue of the worker contains a single file, which is processed with the
+                //standard sequential implementation
+                workerProcessor->Run();
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            
+            if (not workerException)
+                workerException = std::current_exception();
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    
+    for (auto &worker: workers)
+        threads.emplace_back(workerLoop, worker.get());
+    
+    for (auto &t: threads)
+        t.join();
+    
+    if (workerException)
+        std::rethrow_exception(workerException);
+    
+    
+    // Aggregate and report timing statistics collected by the workers
+    if (profiling)
+    {
+        InitializeProfile();
+        
+        for (auto const &worker: workers)
+        {
+            for (auto const &entry: worker->treeStats)
+            {
+                auto &stats = treeStats[entry.first];
+                stats.first += entry.second.first;
+                stats.second += entry.second.second;
+            }
+            
+            if (worker->pluginStats.size() != pluginStats.size())
+                continue;
+            
+            for (unsigned i = 0; i < pluginStats.size(); ++i)
+            {
+                pluginStats[i].numCalls += worker->pluginStats[i].numCalls;
+                pluginStats[i].numOk += worker->pluginStats[i].numOk;
+                pluginStats[i].numRejected += worker->pluginStats[i].numRejected;
+                pluginStats[i].wallTime += worker->pluginStats[i].wallTime;
+            }
+        }
+        
+        ReportProfile();
+        
+        if (not profileJSONPath.empty())
+            WriteProfileJSON();
+    }
+}
+
+
+unsigned long long Processor::ProcessFilePipelined(DelphesReaderBase *reader)
+{
+    using EventData = DelphesReaderBase::EventData;
+    
+    std::size_t const queueCapacity = 64;
+    SPSCQueue<EventData> filledEvents(queueCapacity), freeSlots(queueCapacity);
+    
+    // Populate the pool of free event buffers
+    for (std::size_t i = 0; i < queueCapacity; ++i)
+    {
+        EventData slot;
+        freeSlots.TryPush(slot);
+    }
+    
+    std::atomic<bool> producerDone{false}, abortRequested{false};
+    std::exception_ptr producerException;
+    
+    
+    // The producer thread decodes events and pushes them into the queue
+    std::thread producer(
+      [&]
+      {
+          try
+          {
+              EventData slot;
+              
+              while (not abortRequested)
+              {
+                  if (not freeSlots.TryPop(slot))
+                  {
+                      std::this_thread::yield();
+                      continue;
+                  }
+                  
+                  if (reader->ProcessEventToOutcome() == Plugin::EventOutcome::NoEvents)
+                      break;
+                  
+                  reader->ExtractEventData(slot);
+                  
+                  while (not filledEvents.TryPush(slot) and not abortRequested)
+                      std::this_thread::yield();
+              }
+          }
+          catch (...)
+          {
+              producerException = std::current_exception();
+          }
+          
+          producerDone = true;
+      });
+    
+    
+    // This thread consumes decoded events and runs the remaining plugins on them
+    unsigned long long numEventsInFile = 0;
+    
+    try
+    {
+        EventData slot;
+        
+        while (true)
+        {
+            if (not filledEvents.TryPop(slot))
+            {
+                if (producerDone)
+                {
+                    // Drain events that were pushed just before the producer finished
+                    if (not filledEvents.TryPop(slot))
+                        break;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+            }
+            
+            reader->AdoptEventData(slot);
+            ++numEventsInFile;
+            
+            for (unsigned iPlugin = 1; iPlugin < path.size(); ++iPlugin)
+            {
+                Plugin::EventOutcome res;
+                
+                if (profiling)
+                {
+                    auto const startTime = std::chrono::steady_clock::now();
+                    res = path[iPlugin]->ProcessEventToOutcome();
+                    auto const stopTime = std::chrono::steady_clock::now();
+                    
+                    PluginStats &stats = pluginStats[iPlugin];
+                    stats.wallTime +=
+                      std::chrono::duration<double>(stopTime - startTime).count();
+                    ++stats.numCalls;
+                    
+                    if (res == Plugin::EventOutcome::Ok)
+                        ++stats.numOk;
+                    else if (res == Plugin::EventOutcome::Rejected)
+                        ++stats.numRejected;
+                }
+                else
+                    res = path[iPlugin]->ProcessEventToOutcome();
+                
+                if (res == Plugin::EventOutcome::Rejected)
+                    break;
+            }
+            
+            while (not freeSlots.TryPush(slot))
+                std::this_thread::yield();
+        }
+    }
+    catch (...)
+    {
+        // Stop the producer before propagating the exception
+        abortRequested = true;
+        producer.join();
+        throw;
+    }
+    
+    producer.join();
+    
+    if (producerException)
+        std::rethrow_exception(producerException);
+    
+    return numEventsInFile;
+}
+
+
+void Processor::MaterializeBookedHistograms()
+{
+    for (auto const &buffer: histogramBuffers)
+    {
+        auto const &binning = buffer->Binning();
+        TH1D *hist = Book<TH1D>(buffer->Directory(), buffer->Name().c_str(),
+          buffer->Title().c_str(), binning.size() - 1, binning.data());
+        
+        // Make sure errors are tracked explicitly; otherwise GetBinError would derive them
+        //from the contents added below
+        if (hist->GetSumw2N() == 0)
+            hist->Sumw2();
+        
+        auto const &sums = buffer->Sums();
+        auto const &sums2 = buffer->SumsSquared();
+        
+        // Contents are added rather than set so that they merge correctly when a single output
+        //file keeps the histograms alive across input files
+        for (unsigned bin = 0; bin < sums.size(); ++bin)
+        {
+            hist->AddBinContent(bin, sums[bin]);
+            hist->SetBinError(bin,
+              std::sqrt(std::pow(hist->GetBinError(bin), 2) + sums2[bin]));
+        }
+        
+        hist->SetEntries(hist->GetEntries() + buffer->NumFills());
+        buffer->Reset();
+    }
+}
+
+
+void Processor::CollectTreeStats()
+{
+    for (auto const &writer: asyncWriters)
+    {
+        TTree const *tree = writer->GetTree();
+        auto &stats = treeStats[tree->GetName()];
+        stats.first += tree->GetTotBytes();
+        stats.second += tree->GetZipBytes();
+    }
+}
+
+
+void Processor::StagingLoop()
+{
+    while (true)
+    {
+        std::string remote;
+        
+        {
+            std::unique_lock<std::mutex> lock(stagingMutex);
+            stagingCondition.wait(lock,
+              [this]
+              {
+                  return stagingStop or
+                    (not stagingQueue.empty() and stagedFiles.size() < maxStagedFiles);
+              });
+            
+            if (stagingStop)
+                return;
+            
+            remote = stagingQueue.front();
+            stagingQueue.pop_front();
+        }
+        
+        
+        // Copy the file into the staging directory
+        std::string const local = (boost::filesystem::path(stagingDir) /
+          boost::filesystem::path(remote).filename()).string();
+        
+        std::unique_ptr<TFile> source(TFile::Open(remote.c_str()));
+        bool const copied = (source and not source->IsZombie() and source->Cp(local.c_str()));
+        
+        if (source)
+            source->Close();
+        
+        {
+            std::lock_guard<std::mutex> lock(stagingMutex);
+            
+            if (discardedStaging.erase(remote) > 0)
+            {
+                // The file has been skipped while it was being staged
+                if (copied)
+                    boost::filesystem::remove(local);
+            }
+            else
+                stagedFiles[remote] = (copied) ? local : std::string();
+        }
+        
+        stagingCondition.notify_all();
+    }
+}
+
+
+void Processor::StartStaging()
+{
+    // The staging thread accesses ROOT objects
+    ROOT::EnableThreadSafety();
+    
+    boost::filesystem::create_directories(stagingDir);
+    
+    
+    // Collect the remote inputs in processing order
+    stagingQueue.clear();
+    stagedFiles.clear();
+    discardedStaging.clear();
+    stagingStop = false;
+    
+    std::queue<std::string> pendingFiles = inputFiles;
+    
+    while (not pendingFiles.empty())
+    {
+        if (IsRemotePath(pendingFiles.front()))
+            stagingQueue.push_back(pendingFiles.front());
+        
+        pendingFiles.pop();
+    }
+    
+    stagingThread = std::thread(&Processor::StagingLoop, this);
+}
+
+
+void Processor::StopStaging()
+{
+    if (not stagingThread.joinable())
+        return;
+    
+    {
+        std::lock_guard<std::mutex> lock(stagingMutex);
+        stagingStop = true;
+    }
+    
+    stagingCondition.notify_all();
+    stagingThread.join();
+    
+    
+    // Delete staged copies that have not been consumed
+    for (auto const &entry: stagedFiles)
+    {
+        if (not entry.second.empty())
+            boost::filesystem::remove(entry.second);
+    }
+    
+    stagedFiles.clear();
+}
+
+
+void Processor::ResolveSelectionBoundary()
+{
+    if (selectionBoundaryIndex >= 0)
+        return;
+    
+    for (unsigned i = 0; i < path.size(); ++i)
+    {
+        if (path[i] == selectionBoundary)
+        {
+            selectionBoundaryIndex = i;
+            return;
+        }
+    }
+    
+    std::ostringstream message;
+    message << "Processor::ResolveSelectionBoundary: The boundary plugin of the selection "
+      "cache is not registered in the path.";
+    throw std::runtime_error(message.str());
+}
+
+
+void Processor::LoadJournal()
+{
+    std::ifstream journal(JournalPath(outputDir));
+    std::string line;
+    
+    while (std::getline(journal, line))
+    {
+        if (not line.empty())
+            processedInputs.insert(line);
+    }
+}
+
+
+void Processor::InitializeProfile()
+{
+    if (pluginStats.size() == path.size())
+        return;
+    
+    pluginStats.clear();
+    
+    for (Plugin const *p: path)
+        pluginStats.emplace_back(PluginName(*p));
+}
+
+
+void Processor::ReportProfile() const
+{
+    std::cout << "\nPer-plugin timing summary:\n";
+    
+    for (auto const &stats: pluginStats)
+    {
+        std::cout << "  " << stats.name << ": " << stats.numCalls << " calls (accepted: " <<
+          stats.numOk << ", rejected: " << stats.numRejected << "), " << stats.wallTime <<
+          " s total";
+        
+        if (stats.numCalls > 0)
+            std::cout << ", " << stats.wallTime / stats.numCalls * 1e6 << " us/call";
+        
+        std::cout << '\n';
+    }
+    
+    
+    if (not treeStats.empty())
+    {
+        std::cout << "\nOutput tree summary:\n";
+        
+        for (auto const &entry: treeStats)
+        {
+            std::cout << "  " << entry.first << ": " << entry.second.first <<
+              " bytes written, " << entry.second.second << " bytes compressed";
+            
+            if (entry.second.second > 0)
+                std::cout << " (ratio " <<
+                  double(entry.second.first) / entry.second.second << ")";
+            
+            std::cout << '\n';
+        }
+    }
+    
+    std::cout << std::flush;
+}
+
+
+void Processor::WriteProfileJSON() const
+{
+    std::ofstream out(profileJSONPath);
+    
+    if (not out)
+    {
+        std::ostringstream message;
+        message << "Processor::WriteProfileJSON: Failed to open file \"" << profileJSONPath <<
+          "\" for writing.";
+        throw std::runtime_error(message.str());
+    }
+    
+    out << "{\n  \"plugins\": [\n";
+    
+    for (unsigned i = 0; i < pluginStats.size(); ++i)
+    {
+        auto const &stats = pluginStats[i];
+        out << "    {\"name\": \"" << stats.name << "\", \"calls\": " << stats.numCalls <<
+          ", \"accepted\": " << stats.numOk << ", \"rejected\": " << stats.numRejected <<
+          ", \"time\": " << stats.wallTime << "}";
+        
+        if (i + 1 < pluginStats.size())
+            out << ',';
+        
+        out << '\n';
+    }
+    
+    out << "  ]\n}\n";
+}
@@ -0,0 +1,216 @@
+#include <SkimReader.hpp>
+
+#include <TLorentzVector.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <cmath>
+
+
+int const SkimReader::maxSize;
+
+
+SkimReader::SkimReader(double jetPtThreshold_, double jetEtaThreshold_):
+    DelphesReaderBase(jetPtThreshold_, jetEtaThreshold_)
+{
+    treeName = "Skim";
+}
+
+
+Plugin *SkimReader::Clone() const
+{
+    SkimReader *clone = new SkimReader(jetPtThreshold, jetEtaThreshold);
+    CopyConfiguration(*clone);
+    
+    return clone;
+}
+
+
+std::vector<Electron> const &SkimReader::GetElectrons() const
+{
+    return electrons;
+}
+
+
+std::vector<Muon> const &SkimReader::GetMuons() const
+{
+    return muons;
+}
+
+
+std::vector<Jet> const &SkimReader::GetJets() const
+{
+    return jets;
+}
+
+
+MissingET const &SkimReader::GetMissPt() const
+{
+    return met;
+}
+
+
+double SkimReader::GetWeight() const
+{
+    return bfWeight;
+}
+
+
+void SkimReader::ReadEvent()
+{
+    // Build the lepton collections. Only the stored fields are set.
+    electrons.clear();
+    
+    for (int i = 0; i < bfNumEle; ++i)
+    {
+        Electron e;
+        
+        e.PT = bfElePt[i];
+        e.Eta = bfEleEta[i];
+        e.Phi = bfElePhi[i];
+        e.Charge = bfEleCharge[i];
+        
+        e.T = e.EhadOverEem = e.IsolationVar = e.IsolationVarRhoCorr = e.SumPtCharged = \
+          e.SumPtNeutral = e.SumPtChargedPU = e.SumPt = 0.;
+        
+        electrons.emplace_back(std::move(e));
+    }
+    
+    muons.clear();
+    
+    for (int i = 0; i < bfNumMu; ++i)
+    {
+        Muon mu;
+        
+        mu.PT = bfMuPt[i];
+        mu.Eta = bfMuEta[i];
+        mu.Phi = bfMuPhi[i];
+        mu.Charge = bfMuCharge[i];
+        
+        mu.T = mu.IsolationVar = mu.IsolationVarRhoCorr = mu.SumPtCharged = mu.SumPtNeutral = \
+          mu.SumPtChargedPU = mu.SumPt = 0.;
+        
+        muons.emplace_back(std::move(mu));
+    }
+    
+    
+    // Build the jet collection, re-applying the kinematic selection
+    jets.clear();
+    
+    for (int i = 0; i < bfNumJet; ++i)
+    {
+        if (bfJetPt[i] < jetPtThreshold or std::abs(bfJetEta[i]) > jetEtaThreshold)
+            continue;
+        
+        Jet j;
+        
+        j.PT = bfJetPt[i];
+        j.Eta = bfJetEta[i];
+        j.Phi = bfJetPhi[i];
+        j.Mass = bfJetMass[i];
+        j.BTag = bfJetBTag[i];
+        
+        j.T = j.DeltaEta = j.DeltaPhi = j.EhadOverEem = 0.;
+        j.TauTag = 0;
+        j.Charge = 0;
+        
+        jets.emplace_back(std::move(j));
+    }
+    
+    
+    met.MET = bfMetPt;
+    met.Phi = bfMetPhi;
+    met.Eta = 0.;
+    
+    
+    // Rebuild the LHE record. The four-momentum components are recomputed from the stored
+    //kinematics so that GenParticle::P4 works as expected.
+    lheParticles.clear();
+    
+    for (int i = 0; i < bfNumLHE; ++i)
+    {
+        GenParticle p;
+        
+        p.PID = bfLHEPid[i];
+        p.M1 = bfLHEMother[i];
+        p.M2 = p.D1 = p.D2 = -1;
+        p.Status = 0;
+        p.Charge = 0;
+        p.IsPU = 0;
+        
+        p.PT = bfLHEPt[i];
+        p.Eta = bfLHEEta[i];
+        p.Phi = bfLHEPhi[i];
+        p.Mass = bfLHEMass[i];
+        
+        TLorentzVector p4;
+        p4.SetPtEtaPhiM(p.PT, p.Eta, p.Phi, p.Mass);
+        p.Px = p4.Px();
+        p.Py = p4.Py();
+        p.Pz = p4.Pz();
+        p.E = p4.E();
+        
+        p.Rapidity = p4.Rapidity();
+        p.T = p.X = p.Y = p.Z = 0.;
+        
+        lheParticles.emplace_back(std::move(p));
+    }
+    
+    
+    // Make sure collections are ordered in pt
+    auto comp = [](auto const &c1, auto const &c2){return (c1.PT > c2.PT);};
+    
+    std::sort(electrons.begin(), electrons.end(), comp);
+    std::sort(muons.begin(), muons.end(), comp);
+    std::sort(jets.begin(), jets.end(), comp);
+    
+    
+    // The LHE collections are filled here rather than by the standard decoding
+    lheParticlesDecoded = lheWeightsDecoded = true;
+}
+
+
+void SkimReader::SetupBuffers()
+{
+    // The skim is cheap to decode as a whole, so all branches are read eagerly
+    tree->SetBranchStatus("*", true);
+    
+    tree->SetBranchAddress("Weight", &bfWeight);
+    
+    tree->SetBranchAddress("NumEle", &bfNumEle);
+    tree->SetBranchAddress("ElePt", bfElePt);
+    tree->SetBranchAddress("EleEta", bfEleEta);
+    tree->SetBranchAddress("ElePhi", bfElePhi);
+    tree->SetBranchAddress("EleCharge", bfEleCharge);
+    
+    tree->SetBranchAddress("NumMu", &bfNumMu);
+    tree->SetBranchAddress("MuPt", bfMuPt);
+    tree->SetBranchAddress("MuEta", bfMuEta);
+    tree->SetBranchAddress("MuPhi", bfMuPhi);
+    tree->SetBranchAddress("MuCharge", bfMuCharge);
+    
+    tree->SetBranchAddress("NumJet", &bfNumJet);
+    tree->SetBranchAddress("JetPt", bfJetPt);
+    tree->SetBranchAddress("JetEta", bfJetEta);
+    tree->SetBranchAddress("JetPhi", bfJetPhi);
+    tree->SetBranchAddress("JetMass", bfJetMass);
+    tree->SetBranchAddress("JetBTag", bfJetBTag);
+    
+    tree->SetBranchAddress("MetPt", &bfMetPt);
+    tree->SetBranchAddress("MetPhi", &bfMetPhi);
+    
+    tree->SetBranchAddress("NumLHE", &bfNumLHE);
+    tree->SetBranchAddress("LHEPid", bfLHEPid);
+    tree->SetBranchAddress("LHEMother", bfLHEMother);
+    tree->SetBranchAddress("LHEPt", bfLHEPt);
+    tree->SetBranchAddress("LHEEta", bfLHEEta);
+    tree->SetBranchAddress("LHEPhi", bfLHEPhi);
+    tree->SetBranchAddress("LHEMass", bfLHEMass);
+    
+    for (auto const &name: {"Weight", "NumEle", "ElePt", "EleEta", "ElePhi", "EleCharge",
+      "NumMu", "MuPt", "MuEta", "MuPhi", "MuCharge",
+      "NumJet", "JetPt", "JetEta", "JetPhi", "JetMass", "JetBTag",
+      "MetPt", "MetPhi",
+      "NumLHE", "LHEPid", "LHEMother", "LHEPt", "LHEEta", "LHEPhi", "LHEMass"})
+        DeclareEagerBranch(name);
+}
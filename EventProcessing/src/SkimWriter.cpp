@@ -0,0 +1,152 @@
+#include <SkimWriter.hpp>
+
+#include <Processor.hpp>
+
+#include <Compression.h>
+#include <TBranch.h>
+#include <TTree.h>
+
+#include <sstream>
+#include <stdexcept>
+
+
+int const SkimWriter::maxSize;
+
+
+SkimWriter::SkimWriter(DelphesReaderBase const *reader_):
+    reader(reader_)
+{}
+
+
+void SkimWriter::BeginFile(TFile *)
+{
+    outTree = processor->Book<TTree>("", "Skim", "Compact skim of selected events");
+    
+    outTree->Branch("Weight", &bfWeight, "Weight/F");
+    
+    outTree->Branch("NumEle", &bfNumEle, "NumEle/I");
+    outTree->Branch("ElePt", bfElePt, "ElePt[NumEle]/F");
+    outTree->Branch("EleEta", bfEleEta, "EleEta[NumEle]/F");
+    outTree->Branch("ElePhi", bfElePhi, "ElePhi[NumEle]/F");
+    outTree->Branch("EleCharge", bfEleCharge, "EleCharge[NumEle]/I");
+    
+    outTree->Branch("NumMu", &bfNumMu, "NumMu/I");
+    outTree->Branch("MuPt", bfMuPt, "MuPt[NumMu]/F");
+    outTree->Branch("MuEta", bfMuEta, "MuEta[NumMu]/F");
+    outTree->Branch("MuPhi", bfMuPhi, "MuPhi[NumMu]/F");
+    outTree->Branch("MuCharge", bfMuCharge, "MuCharge[NumMu]/I");
+    
+    outTree->Branch("NumJet", &bfNumJet, "NumJet/I");
+    outTree->Branch("JetPt", bfJetPt, "JetPt[NumJet]/F");
+    outTree->Branch("JetEta", bfJetEta, "JetEta[NumJet]/F");
+    outTree->Branch("JetPhi", bfJetPhi, "JetPhi[NumJet]/F");
+    outTree->Branch("JetMass", bfJetMass, "JetMass[NumJet]/F");
+    outTree->Branch("JetBTag", bfJetBTag, "JetBTag[NumJet]/i");
+    
+    outTree->Branch("MetPt", &bfMetPt, "MetPt/F");
+    outTree->Branch("MetPhi", &bfMetPhi, "MetPhi/F");
+    
+    outTree->Branch("NumLHE", &bfNumLHE, "NumLHE/I");
+    outTree->Branch("LHEPid", bfLHEPid, "LHEPid[NumLHE]/I");
+    outTree->Branch("LHEMother", bfLHEMother, "LHEMother[NumLHE]/I");
+    outTree->Branch("LHEPt", bfLHEPt, "LHEPt[NumLHE]/F");
+    outTree->Branch("LHEEta", bfLHEEta, "LHEEta[NumLHE]/F");
+    outTree->Branch("LHEPhi", bfLHEPhi, "LHEPhi[NumLHE]/F");
+    outTree->Branch("LHEMass", bfLHEMass, "LHEMass[NumLHE]/F");
+    
+    
+    // Skims are scratch files that are traded for speed, so use the fast LZ4 compression
+    TIter next(outTree->GetListOfBranches());
+    TBranch *branch;
+    
+    while ((branch = dynamic_cast<TBranch *>(next())))
+    {
+        branch->SetCompressionAlgorithm(ROOT::kLZ4);
+        branch->SetCompressionLevel(4);
+    }
+}
+
+
+Plugin *SkimWriter::Clone() const
+{
+    return new SkimWriter(reader);
+}
+
+
+void SkimWriter::RebindPlugin(Plugin const *from, Plugin const *to)
+{
+    if (reader == from)
+        reader = dynamic_cast<DelphesReaderBase const *>(to);
+}
+
+
+bool SkimWriter::ProcessEvent()
+{
+    auto const &electrons = reader->GetElectrons();
+    auto const &muons = reader->GetMuons();
+    auto const &jets = reader->GetJets();
+    auto const &lheParticles = reader->GetLHEParticles();
+    
+    if (int(electrons.size()) > maxSize or int(muons.size()) > maxSize or
+      int(jets.size()) > maxSize or int(lheParticles.size()) > maxSize)
+    {
+        std::ostringstream message;
+        message << "SkimWriter::ProcessEvent: Number of objects in the current event exceeds "
+          "the capacity of the skim buffers.";
+        throw std::runtime_error(message.str());
+    }
+    
+    
+    bfWeight = reader->GetWeight();
+    
+    bfNumEle = electrons.size();
+    
+    for (int i = 0; i < bfNumEle; ++i)
+    {
+        bfElePt[i] = electrons[i].PT;
+        bfEleEta[i] = electrons[i].Eta;
+        bfElePhi[i] = electrons[i].Phi;
+        bfEleCharge[i] = electrons[i].Charge;
+    }
+    
+    bfNumMu = muons.size();
+    
+    for (int i = 0; i < bfNumMu; ++i)
+    {
+        bfMuPt[i] = muons[i].PT;
+        bfMuEta[i] = muons[i].Eta;
+        bfMuPhi[i] = muons[i].Phi;
+        bfMuCharge[i] = muons[i].Charge;
+    }
+    
+    bfNumJet = jets.size();
+    
+    for (int i = 0; i < bfNumJet; ++i)
+    {
+        bfJetPt[i] = jets[i].PT;
+        bfJetEta[i] = jets[i].Eta;
+        bfJetPhi[i] = jets[i].Phi;
+        bfJetMass[i] = jets[i].Mass;
+        bfJetBTag[i] = jets[i].BTag;
+    }
+    
+    auto const &met = reader->GetMissPt();
+    bfMetPt = met.MET;
+    bfMetPhi = met.Phi;
+    
+    bfNumLHE = lheParticles.size();
+    
+    for (int i = 0; i < bfNumLHE; ++i)
+    {
+        bfLHEPid[i] = lheParticles[i].PID;
+        bfLHEMother[i] = lheParticles[i].M1;
+        bfLHEPt[i] = lheParticles[i].PT;
+        bfLHEEta[i] = lheParticles[i].Eta;
+        bfLHEPhi[i] = lheParticles[i].Phi;
+        bfLHEMass[i] = lheParticles[i].Mass;
+    }
+    
+    
+    outTree->Fill();
+    return true;
+}
@@ -1,8 +1,12 @@
 #include <SmearMttWriter.hpp>
 
+#include <AsyncTreeWriter.hpp>
+#include <NpyColumnFile.hpp>
 #include <Processor.hpp>
 
-#include <TTree.h>
+#include <TFile.h>
+
+#include <boost/filesystem.hpp>
 
 
 SmearMttWriter::SmearMttWriter(DelphesReaderBase const *reader_, double resolution_):
@@ -11,13 +15,63 @@ SmearMttWriter::SmearMttWriter(DelphesReaderBase const *reader_, double resoluti
 {}
 
 
-void SmearMttWriter::BeginFile(TFile *)
+Plugin *SmearMttWriter::Clone() const
 {
-    outTree = processor->Book<TTree>("", "Vars", "Mass of tt system");
+    SmearMttWriter *clone = new SmearMttWriter(reader, resolution);
+    clone->npyDir = npyDir;
+    
+    return clone;
+}
+
+
+void SmearMttWriter::RebindPlugin(Plugin const *from, Plugin const *to)
+{
+    if (reader == from)
+        reader = dynamic_cast<DelphesReaderBase const *>(to);
+}
+
+
+void SmearMttWriter::BeginFile(TFile *inputFile)
+{
+    // The key is derived from the base name of the file, which, unlike the full path, does not
+    //change when the file is staged into a local cache or accessed through a different mount
+    fileKey = CounterRNG::HashName(
+      boost::filesystem::path(inputFile->GetName()).filename().string());
+    
+    outTree = processor->BookAsyncTree("", "Vars", "Mass of tt system");
     
     outTree->Branch("Weight", &bfWeight);
     outTree->Branch("PartonMassTT", &bfPartonMassTT);
     outTree->Branch("MassTT", &bfMassTT);
+    
+    
+    // Open the column files of this input file if the columnar export has been requested
+    if (not npyDir.empty())
+    {
+        namespace fs = boost::filesystem;
+        fs::create_directories(npyDir);
+        
+        std::string const stem = fs::path(inputFile->GetName()).stem().string();
+        std::string const base = (fs::path(npyDir) / stem).string();
+        
+        npyWeight.reset(new NpyColumnFile(base + "_Weight.npy"));
+        npyPartonMassTT.reset(new NpyColumnFile(base + "_PartonMassTT.npy"));
+        npyMassTT.reset(new NpyColumnFile(base + "_MassTT.npy"));
+    }
+}
+
+
+void SmearMttWriter::EndFile()
+{
+    npyWeight.reset();
+    npyPartonMassTT.reset();
+    npyMassTT.reset();
+}
+
+
+void SmearMttWriter::SetNpyOutput(std::string const &directory)
+{
+    npyDir = directory;
 }
 
 
@@ -26,21 +80,22 @@ bool SmearMttWriter::ProcessEvent()
     bfWeight = reader->GetWeight();
     
     
-    // Compute parton-level mass
-    auto const &particles = reader->GetLHEParticles();
-    TLorentzVector p4TT;
+    // Compute parton-level mass from the cached four-momentum of the tt system
+    bfPartonMassTT = reader->GetPartonTTP4().M();
     
-    for (auto const &p: particles)
-    {
-        if (std::abs(p.PID) == 6)
-            p4TT += p.P4();
-    }
     
-    bfPartonMassTT = p4TT.M();
+    // Smear the mass with the random-number stream of this event, which makes the result
+    //independent of the processing order
+    rGen.SetStream(fileKey, reader->GetReadEntry());
+    bfMassTT = rGen.Gaus(bfPartonMassTT, bfPartonMassTT * resolution);
     
     
-    // Smear the mass
-    bfMassTT = rGen.Gaus(bfPartonMassTT, bfPartonMassTT * resolution);
+    if (npyWeight)
+    {
+        npyWeight->Append(bfWeight);
+        npyPartonMassTT->Append(bfPartonMassTT);
+        npyMassTT->Append(bfMassTT);
+    }
     
     
     outTree->Fill();
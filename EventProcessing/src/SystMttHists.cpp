@@ -1,9 +1,18 @@
 #include "SystMttHists.hpp"
 
+#include <HistogramBuffer.hpp>
 #include <Processor.hpp>
 
+#include <TFile.h>
 #include <TH1D.h>
 
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
 
 SystMttHists::SystMttHists(DelphesReaderBase const *reader_, std::vector<double> const &binning_,
   double resolution_, double scaleVariation_):
@@ -12,33 +21,67 @@ SystMttHists::SystMttHists(DelphesReaderBase const *reader_, std::vector<double>
 {}
 
 
-void SystMttHists::BeginFile(TFile *)
+Plugin *SystMttHists::Clone() const
+{
+    return new SystMttHists(reader, binning, resolution, scaleVariation);
+}
+
+
+void SystMttHists::RebindPlugin(Plugin const *from, Plugin const *to)
+{
+    if (reader == from)
+        reader = dynamic_cast<DelphesReaderBase const *>(to);
+}
+
+
+void SystMttHists::BeginFile(TFile *inputFile)
 {
-    histNominal = processor->Book<TH1D>("", "Nominal", "", binning.size() - 1, binning.data());
-    histScaleUp = processor->Book<TH1D>("", "ScaleUp", "", binning.size() - 1, binning.data());
-    histScaleDown = processor->Book<TH1D>("", "ScaleDown", "", binning.size() - 1, binning.data());
+    // The key is derived from the base name of the file, which, unlike the full path, does not
+    //change when the file is staged into a local cache or accessed through a different mount
+    fileKey = CounterRNG::HashName(
+      boost::filesystem::path(inputFile->GetName()).filename().string());
+    
+    // The handles are stable across input files; repeated bookings return the existing buffers
+    histNominal = processor->BookHistogram("", "Nominal", "", binning);
+    histScaleUp = processor->BookHistogram("", "ScaleUp", "", binning);
+    histScaleDown = processor->BookHistogram("", "ScaleDown", "", binning);
     
-    histAltWeightsBooked = false;
-    histAltWeights.clear();
+    altWeightIDs.clear();
+    altWeightSums.clear();
+    numEventsInFile = 0;
 }
 
 
-bool SystMttHists::ProcessEvent()
+void SystMttHists::EndFile()
 {
-    // Compute parton-level mass
-    auto const &particles = reader->GetLHEParticles();
-    TLorentzVector p4TT;
+    // Materialize histograms with alternative weights from the accumulated sums
+    unsigned const numWeights = altWeightIDs.size();
     
-    for (auto const &p: particles)
+    for (unsigned i = 0; i < numWeights; ++i)
     {
-        if (std::abs(p.PID) == 6)
-            p4TT += p.P4();
+        TH1D *hist = processor->Book<TH1D>("",
+          ("AltWeight_ID" + std::to_string(altWeightIDs[i])).c_str(), "",
+          binning.size() - 1, binning.data());
+        
+        // The sums are added to, rather than set, so that the histograms also accumulate
+        //correctly when a merged output file keeps them alive across input files
+        for (unsigned bin = 0; bin < binning.size() + 1; ++bin)
+            hist->AddBinContent(bin, altWeightSums[bin * numWeights + i]);
+        
+        hist->SetEntries(hist->GetEntries() + numEventsInFile);
     }
-    
-    double const partonMtt = p4TT.M();
+}
+
+
+bool SystMttHists::ProcessEvent()
+{
+    // Compute parton-level mass from the cached four-momentum of the tt system
+    double const partonMtt = reader->GetPartonTTP4().M();
     
     
-    // Apply smearing
+    // Apply smearing with the random-number stream of this event, which makes the result
+    //independent of the processing order
+    rGen.SetStream(fileKey, reader->GetReadEntry());
     double const smearedMtt = rGen.Gaus(partonMtt, partonMtt * resolution);
     
     
@@ -51,22 +94,37 @@ bool SystMttHists::ProcessEvent()
     
     auto const &lheWeights = reader->GetLHEWeights();
     
-    // Book histograms with alternative weights if not done yet
-    if (not histAltWeightsBooked)
+    // Set up the accumulation array when the weights are first seen
+    if (altWeightIDs.empty() and not lheWeights.empty())
     {
         for (auto const &weight: lheWeights)
-            histAltWeights.emplace_back(
-                processor->Book<TH1D>("", ("AltWeight_ID" + std::to_string(weight.ID)).c_str(), "",
-                    binning.size() - 1, binning.data())
-            );
+            altWeightIDs.push_back(weight.ID);
         
-        histAltWeightsBooked = true;
+        altWeightSums.assign((binning.size() + 1) * altWeightIDs.size(), 0.);
     }
     
+    if (lheWeights.size() != altWeightIDs.size())
+    {
+        std::ostringstream message;
+        message << "SystMttHists::ProcessEvent: Number of LHE weights changed from " <<
+          altWeightIDs.size() << " to " << lheWeights.size() << " within one file.";
+        throw std::runtime_error(message.str());
+    }
+    
+    
+    // Determine the bin once and add the whole vector of weights into the accumulation array.
+    //The indexing matches ROOT conventions: bin 0 is the underflow.
+    if (not altWeightIDs.empty())
+    {
+        unsigned const bin =
+          std::upper_bound(binning.begin(), binning.end(), smearedMtt) - binning.begin();
+        double *sums = &altWeightSums[bin * altWeightIDs.size()];
+        
+        for (unsigned i = 0; i < lheWeights.size(); ++i)
+            sums[i] += lheWeights[i].Weight;
+    }
     
-    // Fill histograms with alternative weights
-    for (unsigned i = 0; i < lheWeights.size(); ++i)
-        histAltWeights[i]->Fill(smearedMtt, lheWeights[i].Weight);
+    ++numEventsInFile;
     
     
     return true;
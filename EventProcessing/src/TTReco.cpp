@@ -6,16 +6,171 @@
 #include <TH1.h>
 #include <TH2.h>
 
+#include <algorithm>
 #include <cmath>
+#include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 
 
+/// Protects merging of statistics of clones into the original plugin
+static std::mutex statsMutex;
+
+
+void TTReco::LogLikelihood1D::Initialize(TH1 const &hist)
+{
+    TAxis const &axis = *hist.GetXaxis();
+    
+    if (axis.GetXbins()->GetSize() != 0)
+        throw std::runtime_error("TTReco::LogLikelihood1D::Initialize: Only uniformly binned "
+          "histograms are supported.");
+    
+    numBins = axis.GetNbins();
+    xMin = axis.GetXmin();
+    invBinWidth = numBins / (axis.GetXmax() - xMin);
+    
+    logContents.resize(numBins + 1);
+    
+    for (int bin = 0; bin <= numBins; ++bin)
+        logContents[bin] = std::log(hist.GetBinContent(bin));
+}
+
+
+bool TTReco::LogLikelihood1D::Evaluate(double x, double &logValue) const
+{
+    double const u = (x - xMin) * invBinWidth;
+    
+    // The negated comparison also catches NaN
+    if (not (u < numBins))
+        return false;
+    
+    int const bin = (u < 0.) ? 0 : int(u) + 1;
+    logValue = logContents[bin];
+    
+    return true;
+}
+
+
+void TTReco::LogLikelihood2D::Initialize(TH2 const &hist)
+{
+    TAxis const &axisX = *hist.GetXaxis();
+    TAxis const &axisY = *hist.GetYaxis();
+    
+    if (axisX.GetXbins()->GetSize() != 0 or axisY.GetXbins()->GetSize() != 0)
+        throw std::runtime_error("TTReco::LogLikelihood2D::Initialize: Only uniformly binned "
+          "histograms are supported.");
+    
+    numBinsX = axisX.GetNbins();
+    xMin = axisX.GetXmin();
+    invBinWidthX = numBinsX / (axisX.GetXmax() - xMin);
+    
+    numBinsY = axisY.GetNbins();
+    yMin = axisY.GetXmin();
+    invBinWidthY = numBinsY / (axisY.GetXmax() - yMin);
+    
+    logContents.resize((numBinsX + 1) * (numBinsY + 1));
+    
+    for (int binX = 0; binX <= numBinsX; ++binX)
+        for (int binY = 0; binY <= numBinsY; ++binY)
+            logContents[binX * (numBinsY + 1) + binY] = std::log(hist.GetBinContent(binX, binY));
+    
+    
+    // Precompute, for every bin of the second axis, the maximum over the first axis, which
+    //bounds the likelihood of any permutation with that value of the second coordinate. Also
+    //locate the peak of the likelihood along the second axis.
+    maxLogOverX.assign(numBinsY + 1, -std::numeric_limits<double>::infinity());
+    
+    for (int binY = 0; binY <= numBinsY; ++binY)
+        for (int binX = 0; binX <= numBinsX; ++binX)
+            maxLogOverX[binY] =
+              std::max(maxLogOverX[binY], logContents[binX * (numBinsY + 1) + binY]);
+    
+    int peakBinY = 1;
+    
+    for (int binY = 2; binY <= numBinsY; ++binY)
+    {
+        if (maxLogOverX[binY] > maxLogOverX[peakBinY])
+            peakBinY = binY;
+    }
+    
+    peakY = yMin + (peakBinY - 0.5) / invBinWidthY;
+}
+
+
+bool TTReco::LogLikelihood2D::EvaluateMaxOverX(double y, double &logValue) const
+{
+    double const v = (y - yMin) * invBinWidthY;
+    
+    // The negated comparison also catches NaN
+    if (not (v < numBinsY))
+        return false;
+    
+    int const binY = (v < 0.) ? 0 : int(v) + 1;
+    logValue = maxLogOverX[binY];
+    
+    return true;
+}
+
+
+bool TTReco::LogLikelihood2D::Evaluate(double x, double y, double &logValue) const
+{
+    double const u = (x - xMin) * invBinWidthX;
+    double const v = (y - yMin) * invBinWidthY;
+    
+    // The negated comparisons also catch NaN
+    if (not (u < numBinsX) or not (v < numBinsY))
+        return false;
+    
+    int const binX = (u < 0.) ? 0 : int(u) + 1;
+    int const binY = (v < 0.) ? 0 : int(v) + 1;
+    logValue = logContents[binX * (numBinsY + 1) + binY];
+    
+    return true;
+}
+
+
 TTReco::TTReco(DelphesReaderBase const *reader_, LJetsSelection const *selector_,
   std::string const &likelihoodFileName):
     reader(reader_), selector(selector_),
+    statsParent(nullptr),
     nuReco(173., 80.419002),  // Masses from param_card
     minPt(0.), maxAbsEta(std::numeric_limits<double>::infinity())
+{
+    likelihoods.emplace_back(LoadLikelihood("", likelihoodFileName));
+}
+
+
+TTReco::~TTReco()
+{
+    if (not statsParent)
+        return;
+    
+    
+    // Merge the statistics of this clone into the original plugin
+    std::lock_guard<std::mutex> lock(statsMutex);
+    
+    statsParent->stats.numEvents += stats.numEvents;
+    statsParent->stats.numPermutationsTried += stats.numPermutationsTried;
+    statsParent->stats.numSubtreesPruned += stats.numSubtreesPruned;
+    statsParent->stats.numPairsPruned += stats.numPairsPruned;
+    
+    for (unsigned i = 0; i < stats.jetMultiplicity.size(); ++i)
+        statsParent->stats.jetMultiplicity[i] += stats.jetMultiplicity[i];
+    
+    statsParent->nuReco.MergeStats(nuReco.GetStats());
+}
+
+
+void TTReco::AddLikelihood(std::string const &name, std::string const &likelihoodFileName)
+{
+    likelihoods.emplace_back(LoadLikelihood(name, likelihoodFileName));
+}
+
+
+TTReco::LikelihoodSet TTReco::LoadLikelihood(std::string const &name,
+  std::string const &likelihoodFileName)
 {
     // Read histograms that define likelihood function
     TFile likelihoodFile(likelihoodFileName.c_str());
@@ -23,46 +178,72 @@ TTReco::TTReco(DelphesReaderBase const *reader_, LJetsSelection const *selector_
     if (likelihoodFile.IsZombie())
     {
         std::ostringstream message;
-        message << "TTReco::TTReco: Failed to open file \"" << likelihoodFileName <<
+        message << "TTReco::LoadLikelihood: Failed to open file \"" << likelihoodFileName <<
           "\" for reading.";
         throw std::runtime_error(message.str());
     }
     
-    likelihoodNuDist = dynamic_cast<TH1 *>(likelihoodFile.Get("NeutrinoDist"));
-    likelihoodMassHad = dynamic_cast<TH2 *>(likelihoodFile.Get("MassesHad"));
+    std::unique_ptr<TH1> histNuDist(dynamic_cast<TH1 *>(likelihoodFile.Get("NeutrinoDist")));
+    std::unique_ptr<TH2> histMassHad(dynamic_cast<TH2 *>(likelihoodFile.Get("MassesHad")));
     
-    likelihoodNuDist->SetDirectory(nullptr);
-    likelihoodMassHad->SetDirectory(nullptr);
+    histNuDist->SetDirectory(nullptr);
+    histMassHad->SetDirectory(nullptr);
     
     likelihoodFile.Close();
     
     
     // Normalize the histograms
-    likelihoodNuDist->Scale(1. / likelihoodNuDist->Integral(), "width");
-    likelihoodMassHad->Scale(1. / likelihoodMassHad->Integral(), "width");
+    histNuDist->Scale(1. / histNuDist->Integral(), "width");
+    histMassHad->Scale(1. / histMassHad->Integral(), "width");
+    
+    
+    // Flatten the histograms into lookup tables of precomputed logarithms, which are much cheaper
+    //to query in the permutation loop. The histograms themselves are not needed afterwards.
+    LikelihoodSet set;
+    set.name = name;
+    set.nuDist.Initialize(*histNuDist);
+    set.massHad.Initialize(*histMassHad);
+    
+    
+    // Save the bound used to prune the permutation loop
+    set.maxLogLikelihoodMassHad = std::log(histMassHad->GetMaximum());
+    
+    return set;
+}
+
+
+Plugin *TTReco::Clone() const
+{
+    TTReco *clone = new TTReco(*this);
+    clone->statsParent = const_cast<TTReco *>(this);
+    clone->stats = Stats();
+    clone->nuReco.ResetStats();
+    
+    return clone;
 }
 
 
-Jet const &TTReco::GetJet(DecayJet type) const
+Jet const &TTReco::GetJet(DecayJet type, unsigned iLikelihood) const
 {
+    Interpretation const &interpretation = interpretations.at(iLikelihood);
     Jet const *jet = nullptr;
     
     switch (type)
     {
         case DecayJet::bTopLep:
-            jet = bTopLep;
+            jet = interpretation.bTopLep;
             break;
         
         case DecayJet::bTopHad:
-            jet = bTopHad;
+            jet = interpretation.bTopHad;
             break;
         
         case DecayJet::q1TopHad:
-            jet = q1TopHad;
+            jet = interpretation.q1TopHad;
             break;
         
         case DecayJet::q2TopHad:
-            jet = q2TopHad;
+            jet = interpretation.q2TopHad;
             break;
         
         default:
@@ -85,15 +266,27 @@ TLorentzVector const &TTReco::GetLeptonP4() const
 }
 
 
-TLorentzVector const &TTReco::GetNeutrinoP4() const
+std::string const &TTReco::GetLikelihoodName(unsigned iLikelihood) const
 {
-    return nuReco.GetSolution();
+    return likelihoods.at(iLikelihood).name;
 }
 
 
-double TTReco::GetRank() const
+TLorentzVector const &TTReco::GetNeutrinoP4(unsigned iLikelihood) const
 {
-    return highestRank;
+    return interpretations.at(iLikelihood).p4Nu;
+}
+
+
+unsigned TTReco::GetNumLikelihoods() const
+{
+    return likelihoods.size();
+}
+
+
+double TTReco::GetRank(unsigned iLikelihood) const
+{
+    return interpretations.at(iLikelihood).rank;
 }
 
 
@@ -103,16 +296,44 @@ unsigned TTReco::GetRecoStatus() const
 }
 
 
-TLorentzVector TTReco::GetTopLepP4() const
+TLorentzVector TTReco::GetTopLepP4(unsigned iLikelihood) const
 {
-    return GetLeptonP4() + GetNeutrinoP4() + GetJet(DecayJet::bTopLep).P4();
+    return GetLeptonP4() + GetNeutrinoP4(iLikelihood) +
+      GetJet(DecayJet::bTopLep, iLikelihood).P4();
 }
 
 
-TLorentzVector TTReco::GetTopHadP4() const
+TLorentzVector TTReco::GetTopHadP4(unsigned iLikelihood) const
 {
-    return GetJet(DecayJet::bTopHad).P4() + GetJet(DecayJet::q1TopHad).P4() +
-      GetJet(DecayJet::q2TopHad).P4();
+    return GetJet(DecayJet::bTopHad, iLikelihood).P4() +
+      GetJet(DecayJet::q1TopHad, iLikelihood).P4() +
+      GetJet(DecayJet::q2TopHad, iLikelihood).P4();
+}
+
+
+void TTReco::PrintStats() const
+{
+    NuReco::Stats const &nuStats = nuReco.GetStats();
+    
+    std::cout << "Reconstruction statistics in TTReco\n";
+    std::cout << "Events reconstructed:   " << stats.numEvents << '\n';
+    std::cout << "Permutations evaluated: " << stats.numPermutationsTried << '\n';
+    std::cout << "Subtrees pruned:        " << stats.numSubtreesPruned << '\n';
+    std::cout << "Pairs pruned:           " << stats.numPairsPruned << '\n';
+    std::cout << "Neutrino solves:        " << nuStats.numSolves << " (unsolvable: " <<
+      nuStats.numUnsolvable << ", grid-scan fallbacks: " << nuStats.numGridScanFallbacks <<
+      ")\n";
+    
+    std::cout << "Selected-jet multiplicity:";
+    
+    for (unsigned i = 0; i < stats.jetMultiplicity.size(); ++i)
+    {
+        if (stats.jetMultiplicity[i] > 0)
+            std::cout << "  " << i << ((i == stats.jetMultiplicity.size() - 1) ? "+: " : ": ") <<
+              stats.jetMultiplicity[i];
+    }
+    
+    std::cout << std::endl;
 }
 
 
@@ -123,11 +344,31 @@ void TTReco::SetJetSelection(double minPt_, double maxAbsEta_)
 }
 
 
+void TTReco::RebindPlugin(Plugin const *from, Plugin const *to)
+{
+    if (reader == from)
+        reader = dynamic_cast<DelphesReaderBase const *>(to);
+    
+    if (selector == from)
+        selector = dynamic_cast<LJetsSelection const *>(to);
+}
+
+
 bool TTReco::ProcessEvent()
 {
-    // Reset data describing the current-best interpretation
-    highestRank = -std::numeric_limits<double>::infinity();
-    bTopLep = bTopHad = q1TopHad = q2TopHad = nullptr;
+    // Invalidate neutrino solutions cached for the previous event
+    nuCache.assign(reader->GetJets().size(), NuSolution());
+    
+    ReconstructEvent(minPt, maxAbsEta);
+    
+    return (recoStatus == 0);
+}
+
+
+void TTReco::ReconstructEvent(double minPtCut, double maxAbsEtaCut) const
+{
+    // Reset data describing the current-best interpretations
+    interpretations.assign(likelihoods.size(), Interpretation());
     
     
     // Apply kinematic selection to jets
@@ -136,10 +377,10 @@ bool TTReco::ProcessEvent()
     
     for (unsigned i = 0; i < jets.size(); ++i)
     {
-        if (std::abs(jets[i].Eta) > maxAbsEta)
+        if (std::abs(jets[i].Eta) > maxAbsEtaCut)
             continue;
         
-        if (jets[i].PT < minPt)
+        if (jets[i].PT < minPtCut)
             break;  // The jet collection is ordered in pt
         
         selectedJetIndices.push_back(i);
@@ -147,97 +388,230 @@ bool TTReco::ProcessEvent()
     
     unsigned const nSelectedJets = selectedJetIndices.size();
     
+    ++stats.numEvents;
+    ++stats.jetMultiplicity[std::min<unsigned>(nSelectedJets, stats.jetMultiplicity.size() - 1)];
+    
     
     // Do not attempt reconstruction if there is not enough jets
     if (nSelectedJets < 4)
     {
         recoStatus = 1;
-        return false;
+        return;
     }
     
     
-    // Loop over all possible ways of jet assignment to find the best one
-    for (unsigned iiBTopLepCand = 0; iiBTopLepCand < nSelectedJets; ++iiBTopLepCand)
+    // Cache four-momenta of the selected jets and of all dijet combinations so that they are not
+    //recomputed for every permutation in the loop below
+    auto const &allJetP4s = reader->GetJetP4s();
+    jetP4s.clear();
+    
+    for (unsigned ii = 0; ii < nSelectedJets; ++ii)
+        jetP4s.emplace_back(allJetP4s[selectedJetIndices[ii]]);
+    
+    dijetP4s.assign(nSelectedJets * nSelectedJets, TLorentzVector());
+    dijetMasses.assign(nSelectedJets * nSelectedJets, 0.);
+    
+    for (unsigned ii = 0; ii < nSelectedJets; ++ii)
+        for (unsigned jj = ii + 1; jj < nSelectedJets; ++jj)
+        {
+            TLorentzVector &p4Dijet = dijetP4s[ii * nSelectedJets + jj];
+            p4Dijet = jetP4s[ii] + jetP4s[jj];
+            dijetMasses[ii * nSelectedJets + jj] = p4Dijet.M();
+        }
+    
+    TLorentzVector const &p4Lep = GetLeptonP4();
+    TLorentzVector const &p4Miss = reader->GetMissPtP4();
+    
+    
+    // Partition the candidates by the b-tagging decision, so that the b-quark slots of the
+    //permutation loop iterate only over valid candidates, and order the light-jet pairs by the
+    //proximity of their mass to the W peak of the primary likelihood, so that promising
+    //combinations are tried first and the pruning cutoffs bite early
+    bCandidates.clear();
+    
+    for (unsigned ii = 0; ii < nSelectedJets; ++ii)
     {
-        // Jets matched to b quarks must be b-tagged
-        if (jets.at(selectedJetIndices.at(iiBTopLepCand)).BTag != 1)
-            continue;
+        if (jets[selectedJetIndices[ii]].BTag == 1)
+            bCandidates.push_back(ii);
+    }
+    
+    orderedPairs.clear();
+    
+    for (unsigned ii = 0; ii < nSelectedJets; ++ii)
+        for (unsigned jj = ii + 1; jj < nSelectedJets; ++jj)
+            orderedPairs.push_back(ii * nSelectedJets + jj);
+    
+    double const peakWMass = likelihoods.front().massHad.peakY;
+    std::sort(orderedPairs.begin(), orderedPairs.end(),
+      [&](unsigned a, unsigned b)
+      {
+          return std::abs(dijetMasses[a] - peakWMass) < std::abs(dijetMasses[b] - peakWMass);
+      });
+    
+    
+    // Reconstruct the neutrino for all b-tagged candidates without a cached solution, in one
+    //batch so that the lepton-side computation is shared
+    batchJetIndices.clear();
+    batchJetP4s.clear();
+    
+    for (unsigned ii: bCandidates)
+    {
+        unsigned const jetIndex = selectedJetIndices[ii];
         
+        if (nuCache[jetIndex].status == 0)
+        {
+            batchJetIndices.push_back(jetIndex);
+            batchJetP4s.push_back(allJetP4s[jetIndex]);
+        }
+    }
+    
+    unsigned const numLikelihoods = likelihoods.size();
+    
+    if (not batchJetIndices.empty())
+    {
+        nuReco.ReconstructBatch(p4Lep, batchJetP4s, p4Miss, batchSolutions);
         
-        // Reconstruct neutrino
-        nuReco.Reconstruct(GetLeptonP4(), jets.at(selectedJetIndices.at(iiBTopLepCand)).P4(),
-          reader->GetMissPt().P4());
+        for (unsigned k = 0; k < batchJetIndices.size(); ++k)
+        {
+            NuSolution &cached = nuCache[batchJetIndices[k]];
+            NuReco::Solution const &solution = batchSolutions[k];
+            
+            if (solution.status != 0)
+            {
+                cached.status = 2;
+                continue;
+            }
+            
+            // Evaluate the neutrino likelihood for all registered likelihood sets; a distance
+            //outside of the range of a set is marked with negative infinity
+            cached.logLikelihoods.assign(numLikelihoods,
+              -std::numeric_limits<double>::infinity());
+            bool anyUsable = false;
+            
+            for (unsigned s = 0; s < numLikelihoods; ++s)
+            {
+                if (likelihoods[s].nuDist.Evaluate(solution.distance,
+                  cached.logLikelihoods[s]))
+                    anyUsable = true;
+            }
+            
+            if (not anyUsable)
+            {
+                cached.status = 2;
+                continue;
+            }
+            
+            cached.status = 1;
+            cached.p4Nu = solution.p4Nu;
+        }
+    }
+    
+    
+    // Loop over all possible ways of jet assignment to find the best one
+    for (unsigned const iiBTopLepCand: bCandidates)
+    {
+        unsigned const jetIndex = selectedJetIndices[iiBTopLepCand];
+        
+        NuSolution const &solution = nuCache[jetIndex];
         
-        if (nuReco.RecoStatus() != 0)
+        if (solution.status != 1)
             continue;
         
         
-        // Compute the likelihood for neutrino reconstruction
-        int bin = likelihoodNuDist->FindFixBin(nuReco.GetCompatibility());
+        // Prune the whole subtree if even the maximal possible likelihood for the hadronic leg
+        //cannot beat the current-best interpretation of any likelihood set
+        bool canImprove = false;
         
-        if (likelihoodNuDist->IsBinOverflow(bin))
-            continue;
+        for (unsigned s = 0; s < numLikelihoods; ++s)
+        {
+            if (solution.logLikelihoods[s] + likelihoods[s].maxLogLikelihoodMassHad >
+              interpretations[s].rank)
+            {
+                canImprove = true;
+                break;
+            }
+        }
         
-        double const curLLNu = std::log(likelihoodNuDist->GetBinContent(bin));
+        if (not canImprove)
+        {
+            ++stats.numSubtreesPruned;
+            continue;
+        }
         
         
         // Check permutations for the hadronic leg of the decay
-        for (unsigned iiBTopHadCand = 0; iiBTopHadCand < nSelectedJets; ++iiBTopHadCand)
+        for (unsigned const iiBTopHadCand: bCandidates)
         {
             if (iiBTopLepCand == iiBTopHadCand)
                 continue;
             
-            // Jets matched to b quarks must be b-tagged
-            if (jets.at(selectedJetIndices.at(iiBTopHadCand)).BTag != 1)
-                continue;
             
-            
-            for (unsigned iiQ1TopHadCand = 0; iiQ1TopHadCand < nSelectedJets; ++iiQ1TopHadCand)
+            for (unsigned const pairIndex: orderedPairs)
             {
-                if (iiQ1TopHadCand == iiBTopLepCand or iiQ1TopHadCand == iiBTopHadCand)
+                unsigned const iiQ1TopHadCand = pairIndex / nSelectedJets;
+                unsigned const iiQ2TopHadCand = pairIndex % nSelectedJets;
+                
+                if (iiQ1TopHadCand == iiBTopLepCand or iiQ1TopHadCand == iiBTopHadCand or
+                  iiQ2TopHadCand == iiBTopLepCand or iiQ2TopHadCand == iiBTopHadCand)
                     continue;
                 
-                // When looping for the subleading light-flavour jet, take into account that the
-                //collection is still ordered in jet pt
-                for (unsigned iiQ2TopHadCand = iiQ1TopHadCand + 1; iiQ2TopHadCand < nSelectedJets;
-                  ++iiQ2TopHadCand)
+                double const wMass = dijetMasses[pairIndex];
+                
+                
+                // Discard the pair if even the most favourable top mass at this W mass cannot
+                //beat the current-best interpretation of any likelihood set
+                bool pairCanImprove = false;
+                
+                for (unsigned s = 0; s < numLikelihoods; ++s)
                 {
-                    if (iiQ2TopHadCand == iiBTopLepCand or iiQ2TopHadCand == iiBTopHadCand)
-                        continue;
+                    double bound;
                     
-                    // An interpretation has been constructed. Compute the full likelihood for it.
-                    TLorentzVector const p4W =
-                      jets.at(selectedJetIndices.at(iiQ1TopHadCand)).P4() +
-                      jets.at(selectedJetIndices.at(iiQ2TopHadCand)).P4();
-                    int bin = likelihoodMassHad->FindFixBin(
-                      (p4W + jets.at(selectedJetIndices.at(iiBTopHadCand)).P4()).M(), p4W.M());
+                    if (likelihoods[s].massHad.EvaluateMaxOverX(wMass, bound) and
+                      solution.logLikelihoods[s] + bound > interpretations[s].rank)
+                    {
+                        pairCanImprove = true;
+                        break;
+                    }
+                }
+                
+                if (not pairCanImprove)
+                {
+                    ++stats.numPairsPruned;
+                    continue;
+                }
+                
+                
+                // An interpretation has been constructed. Compute the full likelihood for it,
+                //for all likelihood sets, using the cached dijet momenta.
+                ++stats.numPermutationsTried;
+                double const topMass = (dijetP4s[pairIndex] + jetP4s[iiBTopHadCand]).M();
+                
+                for (unsigned s = 0; s < numLikelihoods; ++s)
+                {
+                    double llMassHad;
                     
-                    if (likelihoodMassHad->IsBinOverflow(bin))
+                    if (not likelihoods[s].massHad.Evaluate(topMass, wMass, llMassHad))
                         continue;
                     
-                    double const rank = curLLNu + std::log(likelihoodMassHad->GetBinContent(bin));
+                    double const rank = solution.logLikelihoods[s] + llMassHad;
+                    Interpretation &interpretation = interpretations[s];
                     
-                    if (rank > highestRank)
+                    if (rank > interpretation.rank)
                     {
-                        highestRank = rank;
+                        interpretation.rank = rank;
                         
-                        bTopLep = &jets.at(selectedJetIndices.at(iiBTopLepCand));
-                        bTopHad = &jets.at(selectedJetIndices.at(iiBTopHadCand));
-                        q1TopHad = &jets.at(selectedJetIndices.at(iiQ1TopHadCand));
-                        q2TopHad = &jets.at(selectedJetIndices.at(iiQ2TopHadCand));
+                        interpretation.bTopLep = &jets[jetIndex];
+                        interpretation.bTopHad = &jets[selectedJetIndices[iiBTopHadCand]];
+                        interpretation.q1TopHad = &jets[selectedJetIndices[iiQ1TopHadCand]];
+                        interpretation.q2TopHad = &jets[selectedJetIndices[iiQ2TopHadCand]];
+                        interpretation.p4Nu = solution.p4Nu;
                     }
                 }
             }
         }
     }
     
-    if (highestRank == -std::numeric_limits<double>::infinity())
-    {
-        recoStatus = 2;
-        return false;
-    }
-    
-    
-    recoStatus = 0;
-    return true;
+    // The event is considered reconstructed when the primary likelihood has succeeded
+    recoStatus =
+      (interpretations[0].rank == -std::numeric_limits<double>::infinity()) ? 2 : 0;
 }
@@ -2,16 +2,19 @@
 
 #include <LJetsSelection.hpp>
 
-#include <TVector2.h>
-
 #include <array>
 #include <cassert>
 #include <cmath>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
 #include <utility>
 
 
+/// Protects merging of thread-local results into the original plugin
+static std::mutex mergeMutex;
+
+
 TTRecoInputs::TTRecoInputs(DelphesReaderBase const *reader_, LJetsSelection const *selector_,
   std::string const &outFileName):
     reader(reader_), selector(selector_),
@@ -20,6 +23,7 @@ TTRecoInputs::TTRecoInputs(DelphesReaderBase const *reader_, LJetsSelection cons
       100, 0., 200.),
     histMassesHad("MassesHad", ";m_{t} [GeV];m_{W} [GeV];Events", 200, 50., 250., 150, 0., 150.),
     nuReco(173., 80.419002),  // Masses from param_card
+    parent(nullptr),
     nVisited(0), nTargetLHE(0), nReconstructable(0), nFilled(0)
 {
     histNeutrinoDist.SetDirectory(&outputFile);
@@ -27,13 +31,61 @@ TTRecoInputs::TTRecoInputs(DelphesReaderBase const *reader_, LJetsSelection cons
 }
 
 
+TTRecoInputs::TTRecoInputs(TTRecoInputs *parent_):
+    reader(parent_->reader), selector(parent_->selector),
+    histNeutrinoDist(parent_->histNeutrinoDist),
+    histMassesHad(parent_->histMassesHad),
+    nuReco(parent_->nuReco),
+    parent(parent_),
+    nVisited(0), nTargetLHE(0), nReconstructable(0), nFilled(0)
+{
+    // The clone accumulates into thread-local histograms, detached from any file
+    histNeutrinoDist.SetDirectory(nullptr);
+    histMassesHad.SetDirectory(nullptr);
+    histNeutrinoDist.Reset();
+    histMassesHad.Reset();
+}
+
+
 TTRecoInputs::~TTRecoInputs()
 {
+    if (parent)
+    {
+        // Merge the thread-local results into the original plugin
+        std::lock_guard<std::mutex> lock(mergeMutex);
+        
+        parent->histNeutrinoDist.Add(&histNeutrinoDist);
+        parent->histMassesHad.Add(&histMassesHad);
+        
+        parent->nVisited += nVisited;
+        parent->nTargetLHE += nTargetLHE;
+        parent->nReconstructable += nReconstructable;
+        parent->nFilled += nFilled;
+        
+        return;
+    }
+    
     outputFile.Write();
     outputFile.Close();
 }
 
 
+Plugin *TTRecoInputs::Clone() const
+{
+    return new TTRecoInputs(const_cast<TTRecoInputs *>(this));
+}
+
+
+void TTRecoInputs::RebindPlugin(Plugin const *from, Plugin const *to)
+{
+    if (reader == from)
+        reader = dynamic_cast<DelphesReaderBase const *>(to);
+    
+    if (selector == from)
+        selector = dynamic_cast<LJetsSelection const *>(to);
+}
+
+
 void TTRecoInputs::PrintCounts() const
 {
     std::cout << "Event counts in TTRecoInputs\n";
@@ -44,28 +96,6 @@ void TTRecoInputs::PrintCounts() const
 }
 
 
-Jet const *TTRecoInputs::MatchJet(GenParticle const *p, double maxDR) const
-{
-    auto const &jets = reader->GetJets();
-    Jet const *match = nullptr;
-    double minDR2 = std::pow(maxDR, 2);
-    
-    for (auto const &j: jets)
-    {
-        double const dR2 = std::pow(p->Eta - j.Eta, 2) +
-          std::pow(TVector2::Phi_mpi_pi(p->Phi - j.Phi), 2);
-        
-        if (dR2 < minDR2)
-        {
-            match = &j;
-            minDR2 = dR2;
-        }
-    }
-    
-    return match;
-}
-
-
 bool TTRecoInputs::ProcessEvent()
 {
     ++nVisited;
@@ -131,19 +161,19 @@ bool TTRecoInputs::ProcessEvent()
     assert(bHad->M1 == particles.at(q1->M1).M1);
     
     
-    // Check if the quarks can be matched to reconstructed jets
-    Jet const *jetBLep = MatchJet(bLep);
-    Jet const *jetBHad = MatchJet(bHad);
-    Jet const *jetQ1 = MatchJet(q1);
-    Jet const *jetQ2 = MatchJet(q2);
+    // Check if the quarks can be matched to distinct reconstructed jets
+    matcher.SetJets(reader->GetJets());
     
-    if (jetBLep == nullptr or jetBHad == nullptr or jetQ1 == nullptr or jetQ2 == nullptr)
-        return false;
+    matchQueries.assign({bLep, bHad, q1, q2});
     
-    if (jetBLep == jetBHad or jetBLep == jetQ1 or jetBLep == jetQ2 or jetBHad == jetQ1 or
-      jetBHad == jetQ2 or jetQ1 == jetQ2)
+    if (not matcher.MatchDistinct(matchQueries, 0.2, matchedJets))
         return false;
     
+    Jet const *jetBLep = matchedJets[0];
+    Jet const *jetBHad = matchedJets[1];
+    Jet const *jetQ1 = matchedJets[2];
+    Jet const *jetQ2 = matchedJets[3];
+    
     
     // Also require that jets matched to the b quarks are b-tagged
     if (jetBLep->BTag != 1 or jetBHad->BTag != 1)
@@ -153,7 +183,7 @@ bool TTRecoInputs::ProcessEvent()
     
     
     // Perform neutrino reconstruction
-    nuReco.Reconstruct(selector->GetLeptonP4(), jetBLep->P4(), reader->GetMissPt().P4());
+    nuReco.Reconstruct(selector->GetLeptonP4(), jetBLep->P4(), reader->GetMissPtP4());
     
     if (nuReco.RecoStatus() != 0)
         return false;
@@ -1,12 +1,12 @@
 #include <TTRecoPerf.hpp>
 
 #include <TH1D.h>
-#include <TVector2.h>
 
 #include <array>
 #include <cassert>
 #include <cmath>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 #include <utility>
 
@@ -45,12 +45,58 @@ TTRecoPerf::~TTRecoPerf()
     histResolution.SetDirectory(&outputFile);
     
     
+    // Do the same for every working point of the cut scan. The vector is reserved upfront so
+    //that the histograms, once attached to the output file, do not move in memory.
+    std::vector<TH1D> scanResolutions;
+    scanResolutions.reserve(hypotheses.size());
+    
+    for (auto const &h: hypotheses)
+    {
+        scanResolutions.emplace_back(("Resolution" + h.suffix).c_str(),
+          ";m_{tt}^{true} [GeV];Relative m_{tt} resolution", 12, 350., 1000.);
+        TH1D &hist = scanResolutions.back();
+        
+        for (int bin = 0; bin <= h.profBias->GetNbinsX() + 1; ++bin)
+        {
+            hist.SetBinContent(bin, std::sqrt(h.profBias2->GetBinContent(bin) -
+              std::pow(h.profBias->GetBinContent(bin), 2)));
+            hist.SetBinError(bin, 0.);
+        }
+        
+        hist.SetDirectory(&outputFile);
+    }
+    
+    
     // Save all results
     outputFile.Write();
     outputFile.Close();
 }
 
 
+void TTRecoPerf::AddSelectionHypothesis(double minPt, double maxAbsEta)
+{
+    Hypothesis h;
+    h.minPt = minPt;
+    h.maxAbsEta = maxAbsEta;
+    
+    std::ostringstream suffix;
+    suffix << "_pt" << minPt << "_eta" << maxAbsEta;
+    h.suffix = suffix.str();
+    
+    h.profBias.reset(new TProfile(("Bias" + h.suffix).c_str(),
+      ";m_{tt}^{true} [GeV];Relative bias in reconstructed m_{tt}", 12, 350., 1000.));
+    h.profEfficiency.reset(new TProfile(("Efficiency" + h.suffix).c_str(),
+      ";m_{tt}^{true} [GeV];Eff. of identification of all jets", 12, 350., 1000.));
+    h.profBias2.reset(new TProfile(("Bias2" + h.suffix).c_str(), "", 12, 350., 1000.));
+    
+    h.profBias->SetDirectory(&outputFile);
+    h.profEfficiency->SetDirectory(&outputFile);
+    h.profBias2->SetDirectory(nullptr);
+    
+    hypotheses.emplace_back(std::move(h));
+}
+
+
 void TTRecoPerf::PrintCounts() const
 {
     std::cout << "Event counts in TTRecoPerf\n";
@@ -60,28 +106,6 @@ void TTRecoPerf::PrintCounts() const
 }
 
 
-Jet const *TTRecoPerf::MatchJet(GenParticle const *p, double maxDR) const
-{
-    auto const &jets = reader->GetJets();
-    Jet const *match = nullptr;
-    double minDR2 = std::pow(maxDR, 2);
-    
-    for (auto const &j: jets)
-    {
-        double const dR2 = std::pow(p->Eta - j.Eta, 2) +
-          std::pow(TVector2::Phi_mpi_pi(p->Phi - j.Phi), 2);
-        
-        if (dR2 < minDR2)
-        {
-            match = &j;
-            minDR2 = dR2;
-        }
-    }
-    
-    return match;
-}
-
-
 bool TTRecoPerf::ProcessEvent()
 {
     ++nVisited;
@@ -147,19 +171,19 @@ bool TTRecoPerf::ProcessEvent()
     assert(bHad->M1 == particles.at(q1->M1).M1);
     
     
-    // Check if the quarks can be matched to reconstructed jets
-    Jet const *jetBLep = MatchJet(bLep, 0.4);
-    Jet const *jetBHad = MatchJet(bHad, 0.4);
-    Jet const *jetQ1 = MatchJet(q1, 0.4);
-    Jet const *jetQ2 = MatchJet(q2, 0.4);
+    // Check if the quarks can be matched to distinct reconstructed jets
+    matcher.SetJets(reader->GetJets());
     
-    if (jetBLep == nullptr or jetBHad == nullptr or jetQ1 == nullptr or jetQ2 == nullptr)
-        return false;
+    matchQueries.assign({bLep, bHad, q1, q2});
     
-    if (jetBLep == jetBHad or jetBLep == jetQ1 or jetBLep == jetQ2 or jetBHad == jetQ1 or
-      jetBHad == jetQ2 or jetQ1 == jetQ2)
+    if (not matcher.MatchDistinct(matchQueries, 0.4, matchedJets))
         return false;
     
+    Jet const *jetBLep = matchedJets[0];
+    Jet const *jetBHad = matchedJets[1];
+    Jet const *jetQ1 = matchedJets[2];
+    Jet const *jetQ2 = matchedJets[3];
+    
     
     // Also require that jets matched to the b quarks are b-tagged
     if (jetBLep->BTag != 1 or jetBHad->BTag != 1)
@@ -191,5 +215,33 @@ bool TTRecoPerf::ProcessEvent()
     profEfficiency.Fill(trueMtt, double(matched), weight);
     
     
+    // Evaluate all working points of the cut scan for the same event. The matching done above is
+    //reused, and the re-ranking uses the neutrino solutions cached by TTReco.
+    for (auto &h: hypotheses)
+    {
+        ttReco->ReconstructEvent(h.minPt, h.maxAbsEta);
+        
+        if (ttReco->GetRecoStatus() != 0)
+        {
+            // The reconstruction failed under this selection, so the jets cannot have been
+            //identified
+            h.profEfficiency->Fill(trueMtt, 0., weight);
+            continue;
+        }
+        
+        double const recoMttWP = (ttReco->GetTopLepP4() + ttReco->GetTopHadP4()).M();
+        double const biasWP = recoMttWP / trueMtt - 1.;
+        h.profBias->Fill(trueMtt, biasWP, weight);
+        h.profBias2->Fill(trueMtt, biasWP * biasWP, weight);
+        
+        bool const matchedWP = (jetBLep == &ttReco->GetJet(TTReco::DecayJet::bTopLep) and
+          jetBHad == &ttReco->GetJet(TTReco::DecayJet::bTopHad) and
+          jetQ1 == &ttReco->GetJet(TTReco::DecayJet::q1TopHad) and
+          jetQ2 == &ttReco->GetJet(TTReco::DecayJet::q2TopHad));
+        
+        h.profEfficiency->Fill(trueMtt, double(matchedWP), weight);
+    }
+    
+    
     return true;
 }
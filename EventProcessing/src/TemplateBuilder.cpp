@@ -0,0 +1,211 @@
+#include <TemplateBuilder.hpp>
+
+#include <TH1.h>
+#include <TH1D.h>
+#include <TKey.h>
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+
+/// Protects merging of thread-local results into the original plugin
+static std::mutex mergeMutex;
+
+
+TemplateBuilder::TemplateBuilder(VarsReader const *reader_, std::vector<double> const &binning_,
+  std::string const &outFileName):
+    reader(reader_),
+    outputFile(outFileName.c_str(), "recreate"),
+    binning(binning_),
+    scaleFactor(1.),
+    parent(nullptr)
+{
+    sums.assign(binning.size() + 1, 0.);
+    sums2.assign(binning.size() + 1, 0.);
+}
+
+
+TemplateBuilder::TemplateBuilder(TemplateBuilder *parent_):
+    reader(parent_->reader),
+    binning(parent_->binning),
+    points(parent_->points),
+    scaleFactor(parent_->scaleFactor),
+    sums(parent_->sums.size(), 0.),
+    sums2(parent_->sums2.size(), 0.),
+    parent(parent_)
+{}
+
+
+TemplateBuilder::~TemplateBuilder()
+{
+    if (parent)
+    {
+        // Merge the thread-local sums into the original plugin
+        std::lock_guard<std::mutex> lock(mergeMutex);
+        
+        for (unsigned i = 0; i < sums.size(); ++i)
+        {
+            parent->sums[i] += sums[i];
+            parent->sums2[i] += sums2[i];
+        }
+        
+        return;
+    }
+    
+    
+    // Materialize the templates from the accumulated sums. The histograms are owned by the
+    //output file.
+    unsigned const stride = points.size() + 1;
+    
+    for (unsigned p = 0; p < stride; ++p)
+    {
+        std::string const name = (p == 0) ? "Nominal" : points[p - 1].name;
+        TH1D *hist = new TH1D(name.c_str(), "", binning.size() - 1, binning.data());
+        
+        for (unsigned bin = 0; bin < binning.size() + 1; ++bin)
+        {
+            hist->SetBinContent(bin, scaleFactor * sums[bin * stride + p]);
+            hist->SetBinError(bin, scaleFactor * std::sqrt(sums2[bin * stride + p]));
+        }
+        
+        hist->SetDirectory(&outputFile);
+    }
+    
+    outputFile.Write();
+    outputFile.Close();
+}
+
+
+void TemplateBuilder::AddReweightedPoint(std::string const &name, TH1 const &weightCurve)
+{
+    TAxis const &axis = *weightCurve.GetXaxis();
+    
+    if (axis.GetXbins()->GetSize() != 0)
+        throw std::runtime_error("TemplateBuilder::AddReweightedPoint: Only uniformly binned "
+          "weight curves are supported.");
+    
+    WeightCurve curve;
+    curve.name = name;
+    
+    int const numBins = axis.GetNbins();
+    curve.xMin = axis.GetXmin();
+    curve.invBinWidth = numBins / (axis.GetXmax() - curve.xMin);
+    
+    curve.values.resize(numBins);
+    
+    for (int bin = 1; bin <= numBins; ++bin)
+        curve.values[bin - 1] = weightCurve.GetBinContent(bin);
+    
+    points.emplace_back(std::move(curve));
+    
+    
+    // Extend the accumulation arrays accordingly
+    sums.assign((binning.size() + 1) * (points.size() + 1), 0.);
+    sums2.assign((binning.size() + 1) * (points.size() + 1), 0.);
+}
+
+
+void TemplateBuilder::AddReweightedPointsFromFile(std::string const &weightFileName)
+{
+    TFile weightFile(weightFileName.c_str());
+    
+    if (weightFile.IsZombie())
+    {
+        std::ostringstream message;
+        message << "TemplateBuilder::AddReweightedPointsFromFile: Failed to open file \"" <<
+          weightFileName << "\" for reading.";
+        throw std::runtime_error(message.str());
+    }
+    
+    TIter next(weightFile.GetListOfKeys());
+    TKey *key;
+    
+    while ((key = dynamic_cast<TKey *>(next())))
+    {
+        TH1 *hist = dynamic_cast<TH1 *>(key->ReadObj());
+        
+        if (not hist)
+            continue;
+        
+        AddReweightedPoint(hist->GetName(), *hist);
+    }
+    
+    weightFile.Close();
+}
+
+
+void TemplateBuilder::BeginFile(TFile *)
+{
+    if (not points.empty() and not reader->HasPartonMassTT())
+        throw std::runtime_error("TemplateBuilder::BeginFile: Reweighting points are "
+          "registered, but the input ntuples do not store the parton-level mtt.");
+}
+
+
+Plugin *TemplateBuilder::Clone() const
+{
+    return new TemplateBuilder(const_cast<TemplateBuilder *>(this));
+}
+
+
+void TemplateBuilder::RebindPlugin(Plugin const *from, Plugin const *to)
+{
+    if (reader == from)
+        reader = dynamic_cast<VarsReader const *>(to);
+}
+
+
+void TemplateBuilder::SetScaleFactor(double scaleFactor_)
+{
+    scaleFactor = scaleFactor_;
+}
+
+
+double TemplateBuilder::EvaluateCurve(WeightCurve const &curve, double x)
+{
+    double const u = (x - curve.xMin) * curve.invBinWidth;
+    int bin = int(u);
+    
+    // Clamp to the range of the curve
+    if (bin < 0)
+        bin = 0;
+    else if (bin >= int(curve.values.size()))
+        bin = curve.values.size() - 1;
+    
+    return curve.values[bin];
+}
+
+
+bool TemplateBuilder::ProcessEvent()
+{
+    double const weight = reader->GetWeight();
+    
+    // Determine the template bin once; the indexing matches ROOT conventions, with bin 0 being
+    //the underflow
+    unsigned const bin =
+      std::upper_bound(binning.begin(), binning.end(), reader->GetMassTT()) - binning.begin();
+    
+    unsigned const stride = points.size() + 1;
+    double *s = &sums[bin * stride];
+    double *s2 = &sums2[bin * stride];
+    
+    s[0] += weight;
+    s2[0] += weight * weight;
+    
+    if (not points.empty())
+    {
+        double const partonMtt = reader->GetPartonMassTT();
+        
+        for (unsigned p = 0; p < points.size(); ++p)
+        {
+            double const w = weight * EvaluateCurve(points[p], partonMtt);
+            s[p + 1] += w;
+            s2[p + 1] += w * w;
+        }
+    }
+    
+    return true;
+}
@@ -0,0 +1,34 @@
+#include <TreeWriteOptions.hpp>
+
+#include <TBranch.h>
+#include <TTree.h>
+
+
+TreeWriteOptions::TreeWriteOptions():
+    compressionAlgorithm(-1), compressionLevel(-1),
+    basketSize(-1),
+    autoFlush(-1)
+{}
+
+
+void TreeWriteOptions::Apply(TBranch &branch) const
+{
+    if (compressionAlgorithm >= 0)
+        branch.SetCompressionAlgorithm(compressionAlgorithm);
+    
+    if (compressionLevel >= 0)
+        branch.SetCompressionLevel(compressionLevel);
+}
+
+
+void TreeWriteOptions::Apply(TTree &tree) const
+{
+    if (autoFlush >= 0)
+        tree.SetAutoFlush(autoFlush);
+}
+
+
+int TreeWriteOptions::BasketSize(int defaultSize) const
+{
+    return (basketSize > 0) ? basketSize : defaultSize;
+}
@@ -1,7 +1,11 @@
 #include <VarWriter.hpp>
 
+#include <AsyncTreeWriter.hpp>
 #include <Processor.hpp>
 
+#include <limits>
+#include <string>
+
 
 VarWriter::VarWriter(DelphesReaderBase const *reader_, TTReco const *ttReco_):
     reader(reader_), ttReco(ttReco_),
@@ -11,7 +15,7 @@ VarWriter::VarWriter(DelphesReaderBase const *reader_, TTReco const *ttReco_):
 
 void VarWriter::BeginFile(TFile *)
 {
-    outTree = processor->Book<TTree>("", "Vars", "Observables computed for tt system");
+    outTree = processor->BookAsyncTree("", "Vars", "Observables computed for tt system");
     
     outTree->Branch("Weight", &bfWeight);
     outTree->Branch("PtTopLep", &bfPtTopLep);
@@ -20,6 +24,43 @@ void VarWriter::BeginFile(TFile *)
     
     if (storePartonLevel)
         outTree->Branch("PartonMassTT", &bfPartonMassTT);
+    
+    
+    // One additional set of branches per alternative likelihood of the reconstruction. The
+    //buffers are sized upfront so that their addresses remain stable.
+    unsigned const numLikelihoods = ttReco->GetNumLikelihoods();
+    
+    bfPtTopLepVar.assign(numLikelihoods - 1, 0.f);
+    bfPtTopHadVar.assign(numLikelihoods - 1, 0.f);
+    bfMassTTVar.assign(numLikelihoods - 1, 0.f);
+    
+    for (unsigned i = 1; i < numLikelihoods; ++i)
+    {
+        std::string const suffix = "_" + ttReco->GetLikelihoodName(i);
+        
+        outTree->Branch(("PtTopLep" + suffix).c_str(), &bfPtTopLepVar[i - 1]);
+        outTree->Branch(("PtTopHad" + suffix).c_str(), &bfPtTopHadVar[i - 1]);
+        outTree->Branch(("MassTT" + suffix).c_str(), &bfMassTTVar[i - 1]);
+    }
+}
+
+
+Plugin *VarWriter::Clone() const
+{
+    VarWriter *clone = new VarWriter(reader, ttReco);
+    clone->StorePartonLevel(storePartonLevel);
+    
+    return clone;
+}
+
+
+void VarWriter::RebindPlugin(Plugin const *from, Plugin const *to)
+{
+    if (reader == from)
+        reader = dynamic_cast<DelphesReaderBase const *>(to);
+    
+    if (ttReco == from)
+        ttReco = dynamic_cast<TTReco const *>(to);
 }
 
 
@@ -42,18 +83,25 @@ bool VarWriter::ProcessEvent()
     
     
     if (storePartonLevel)
+        bfPartonMassTT = reader->GetPartonTTP4().M();
+    
+    
+    // Observables for the alternative likelihoods. Zeros are stored when the reconstruction
+    //with a given likelihood has failed for this event.
+    for (unsigned i = 1; i < ttReco->GetNumLikelihoods(); ++i)
     {
-        auto const &particles = reader->GetLHEParticles();
-        
-        TLorentzVector p4TT;
-        
-        for (auto const &p: particles)
+        if (ttReco->GetRank(i) == -std::numeric_limits<double>::infinity())
         {
-            if (std::abs(p.PID) == 6)
-                p4TT += p.P4();
+            bfPtTopLepVar[i - 1] = bfPtTopHadVar[i - 1] = bfMassTTVar[i - 1] = 0.f;
+            continue;
         }
         
-        bfPartonMassTT = p4TT.M();
+        TLorentzVector const p4TopLepVar = ttReco->GetTopLepP4(i);
+        TLorentzVector const p4TopHadVar = ttReco->GetTopHadP4(i);
+        
+        bfPtTopLepVar[i - 1] = p4TopLepVar.Pt();
+        bfPtTopHadVar[i - 1] = p4TopHadVar.Pt();
+        bfMassTTVar[i - 1] = (p4TopLepVar + p4TopHadVar).M();
     }
     
     
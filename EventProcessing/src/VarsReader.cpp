@@ -0,0 +1,80 @@
+#include <VarsReader.hpp>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include <sstream>
+#include <stdexcept>
+
+
+VarsReader::VarsReader():
+    tree(nullptr),
+    hasPartonMassTT(false)
+{}
+
+
+void VarsReader::BeginFile(TFile *inputFile)
+{
+    tree = dynamic_cast<TTree *>(inputFile->Get("Vars"));
+    
+    if (not tree)
+    {
+        std::ostringstream message;
+        message << "VarsReader::BeginFile: File \"" << inputFile->GetName() <<
+          "\" does not contain a tree \"Vars\".";
+        throw std::runtime_error(message.str());
+    }
+    
+    numEvents = tree->GetEntries();
+    iEvent = 0;
+    
+    tree->SetBranchAddress("Weight", &bfWeight);
+    tree->SetBranchAddress("MassTT", &bfMassTT);
+    
+    hasPartonMassTT = (tree->GetBranch("PartonMassTT") != nullptr);
+    
+    if (hasPartonMassTT)
+        tree->SetBranchAddress("PartonMassTT", &bfPartonMassTT);
+}
+
+
+Plugin *VarsReader::Clone() const
+{
+    return new VarsReader;
+}
+
+
+double VarsReader::GetMassTT() const
+{
+    return bfMassTT;
+}
+
+
+double VarsReader::GetPartonMassTT() const
+{
+    return bfPartonMassTT;
+}
+
+
+double VarsReader::GetWeight() const
+{
+    return bfWeight;
+}
+
+
+bool VarsReader::HasPartonMassTT() const
+{
+    return hasPartonMassTT;
+}
+
+
+Plugin::EventOutcome VarsReader::ProcessEventToOutcome()
+{
+    if (iEvent == numEvents)
+        return Plugin::EventOutcome::NoEvents;
+    
+    tree->GetEntry(iEvent);
+    ++iEvent;
+    
+    return Plugin::EventOutcome::Ok;
+}